@@ -0,0 +1,56 @@
+#pragma once
+#ifndef CGE_BENCH_UTILS
+#define CGE_BENCH_UTILS
+
+// Helpers shared by the benchmarks in bench/. A bench that counts heap
+// allocations defines CGE_BENCH_COUNT_ALLOCATIONS before including this
+// header, which replaces the global operator new and delete for that
+// program; define it in one file per program only
+
+#include <chrono>
+#include <cstdint>
+
+using bench_clock = std::chrono::high_resolution_clock;
+
+static inline double elapsed_ms(bench_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+#ifdef CGE_BENCH_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> bench_allocation_counter{0};
+
+// Calls to any form of operator new since the program started
+static inline uint64_t bench_allocation_count() {
+    return bench_allocation_counter.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+    bench_allocation_counter.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    bench_allocation_counter.fetch_add(1, std::memory_order_relaxed);
+    // aligned_alloc wants a non-zero multiple of the alignment
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t rounded = ((size ? size : 1) + align - 1) / align * align;
+    if (void* memory = std::aligned_alloc(align, rounded))
+        return memory;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+#endif /* CGE_BENCH_COUNT_ALLOCATIONS */
+
+#endif /* CGE_BENCH_UTILS */
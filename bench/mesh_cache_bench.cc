@@ -0,0 +1,67 @@
+// Compares a cold OBJ import against loading the same mesh from its .cgemesh cache.
+// The cached path includes copying the mapped arrays into a host buffer, which
+// stands in for the staging buffer write done by CGE_Model.
+//
+// Usage: bin/mesh_cache_bench [iterations] [model.obj ...]
+#include "bench_utils.hh"
+#include "cge_model.hh"
+#include "cge_mesh_cache.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 10;
+    std::vector<std::string> models;
+    for (int i = 2; i < argc; i++) {
+        models.push_back(argv[i]);
+    }
+    if (models.empty()) {
+        models = {"models/smooth_vase.obj", "models/flat_vase.obj"};
+    }
+
+    for (const auto& model : models) {
+        // Make sure the cache exists and is current before timing the cached path
+        cge::CGE_Model::Builder warmup{};
+        warmup.load_models(model);
+
+        double cold_ms = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            cge::CGE_Model::Builder builder{};
+            builder.write_cache = false;
+
+            auto start = bench_clock::now();
+            builder.load_models(model);
+            cold_ms += elapsed_ms(start);
+        }
+
+        double cached_ms = 0.0;
+        std::vector<char> staging;
+        for (int i = 0; i < iterations; i++) {
+            auto start = bench_clock::now();
+            auto cached = cge::CGE_Mesh_Cache::load(model, warmup.cache_key());
+            if (!cached) {
+                std::cerr << "cache miss for " << model << std::endl;
+                return 1;
+            }
+
+            size_t vertex_bytes = cached->vertex_count() * sizeof(cge::CGE_Model::Vertex);
+            size_t index_bytes = cached->index_count() * sizeof(uint32_t);
+            staging.resize(vertex_bytes + index_bytes);
+            std::memcpy(staging.data(), cached->vertices(), vertex_bytes);
+            std::memcpy(staging.data() + vertex_bytes, cached->indices(), index_bytes);
+            cached_ms += elapsed_ms(start);
+        }
+
+        std::cout << model << " (" << warmup.vertices.size() << " vertices, "
+                  << warmup.indices.size() << " indices)" << std::endl;
+        std::cout << "\tcold obj import: " << cold_ms / iterations << " ms" << std::endl;
+        std::cout << "\tcached load:     " << cached_ms / iterations << " ms" << std::endl;
+        std::cout << "\tspeedup:         " << cold_ms / cached_ms << "x" << std::endl;
+    }
+
+    return 0;
+}
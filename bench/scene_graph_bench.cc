@@ -0,0 +1,133 @@
+// World transform propagation through CGE_Scene_Graph: a forest of random
+// trees where 1% of the nodes move each frame (only their subtrees are
+// recomputed) and where every root moves (the whole graph is recomputed),
+// on one thread and on every hardware thread. Heap allocations per update
+// are counted, and the result is checked against multiplying each node's
+// local matrices up to its root.
+//
+// Usage: bin/scene_graph_bench [frames] [objects] [nodes per tree]
+#define CGE_BENCH_COUNT_ALLOCATIONS
+#include "bench_utils.hh"
+#include "cge_ecs.hh"
+#include "cge_game_object.hh"
+#include "cge_scene_graph.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using cge::CGE_Entity;
+using cge::CGE_Scene_Graph;
+using cge::CGE_World;
+using cge::TransformComponent;
+using cge::WorldTransformComponent;
+
+// Each node's parent is a random earlier node of its tree
+static std::vector<CGE_Entity> create_forest(CGE_World& world, CGE_Scene_Graph& graph, uint32_t objects, uint32_t tree_size) {
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> position{-2.f, 2.f};
+    std::uniform_real_distribution<float> angle{0.f, 6.2831853f};
+    std::uniform_real_distribution<float> size{0.8f, 1.2f};
+
+    std::vector<CGE_Entity> entities;
+    entities.reserve(objects);
+    for (uint32_t i = 0; i < objects; i++) {
+        CGE_Entity entity = world.create(TransformComponent{
+            {position(rng), position(rng), position(rng)},
+            glm::vec3{size(rng)},
+            {angle(rng), angle(rng), angle(rng)}});
+
+        uint32_t tree_index = i % tree_size;
+        CGE_Entity parent{};
+        if (tree_index > 0) {
+            parent = entities[i - 1 - rng() % tree_index];
+        }
+        graph.set_parent(world, entity, parent);
+        entities.push_back(entity);
+    }
+    return entities;
+}
+
+static void move(CGE_World& world, const std::vector<CGE_Entity>& entities, uint32_t stride, uint32_t frame) {
+    float offset = (frame & 1) ? 0.01f : -0.01f;
+    for (size_t i = 0; i < entities.size(); i += stride) {
+        TransformComponent& transform = *world.get<TransformComponent>(entities[i]);
+        transform.translate(glm::vec3{offset, 0.f, 0.f});
+        transform.set_rotation(transform.get_rotation() + glm::vec3{0.f, offset, 0.f});
+    }
+}
+
+static float max_error(CGE_World& world, CGE_Scene_Graph& graph, const std::vector<CGE_Entity>& entities) {
+    float error = 0.f;
+    for (CGE_Entity entity : entities) {
+        glm::mat4 expected{1.f};
+        for (CGE_Entity node = entity; node.valid(); node = graph.get_parent(node)) {
+            expected = world.get<TransformComponent>(node)->mat4() * expected;
+        }
+        const glm::mat4& actual = world.get<WorldTransformComponent>(entity)->matrix;
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) {
+                float difference = std::fabs(actual[column][row] - expected[column][row]);
+                error = std::max(error, difference / std::max(1.f, std::fabs(expected[column][row])));
+            }
+        }
+    }
+    return error;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 100;
+    uint32_t objects = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 100000;
+    uint32_t tree_size = argc > 3 ? std::max(1, std::atoi(argv[3])) : 100;
+
+    std::vector<unsigned> thread_counts{1};
+    if (std::thread::hardware_concurrency() > 1) {
+        thread_counts.push_back(std::thread::hardware_concurrency());
+    }
+    struct Scenario {
+        const char* name;
+        uint32_t stride;
+    };
+    const Scenario scenarios[] = {
+        {"1% moving", 97},
+        {"roots moving", tree_size},
+    };
+
+    bool accurate = true;
+    for (unsigned threads : thread_counts) {
+        CGE_World world;
+        CGE_Scene_Graph graph{threads};
+        std::vector<CGE_Entity> entities = create_forest(world, graph, objects, tree_size);
+        graph.update(world);
+
+        std::cout << objects << " objects in " << graph.get_root_count() << " trees, "
+                  << frames << " frames, " << threads << " thread(s)" << std::endl;
+
+        for (const Scenario& scenario : scenarios) {
+            double total_ms = 0.0;
+            uint64_t recomputed = 0;
+            uint64_t allocations = 0;
+            for (int frame = 0; frame < frames; frame++) {
+                move(world, entities, scenario.stride, frame);
+                uint64_t allocations_before = bench_allocation_count();
+                auto start = bench_clock::now();
+                recomputed += graph.update(world);
+                total_ms += elapsed_ms(start);
+                allocations += bench_allocation_count() - allocations_before;
+            }
+
+            float error = max_error(world, graph, entities);
+            accurate = accurate && error < 1e-4f;
+            std::cout << "\t" << scenario.name << ": " << total_ms / frames << " ms/frame, "
+                      << recomputed / frames << " nodes recomputed, "
+                      << static_cast<double>(allocations) / frames << " allocations/frame, max error "
+                      << error << std::endl;
+        }
+    }
+
+    return accurate ? 0 : 1;
+}
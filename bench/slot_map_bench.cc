@@ -0,0 +1,143 @@
+// Projectile churn: a steady population where a fixed number of
+// projectiles spawn and expire every frame, positions are integrated by
+// iterating all of them and some are looked up by handle (hit tests).
+// Compares the old game object storage (a vector of objects holding a
+// shared_ptr, found by id) with CGE_Slot_Map and with CGE_World entities,
+// and counts heap allocations once the population has settled.
+//
+// Usage: bin/slot_map_bench [frames] [projectiles] [spawned per frame]
+#define CGE_BENCH_COUNT_ALLOCATIONS
+#include "bench_utils.hh"
+#include "cge_ecs.hh"
+#include "cge_slot_map.hh"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using cge::CGE_Entity;
+using cge::CGE_Slot_Map;
+using cge::CGE_World;
+
+struct Projectile {
+    glm::vec3 position{};
+    glm::vec3 velocity{};
+};
+
+// What CGE_Game_Object looked like: an id from a counter and a shared model
+struct Old_Object {
+    uint32_t id;
+    std::shared_ptr<int> model;
+    Projectile projectile;
+};
+
+struct Result {
+    double ms = 0.0;
+    double allocations = 0.0;
+    float checksum = 0.f;
+};
+
+// Runs frames of churn. Spawn returns a handle, despawn takes one, each
+// visits every projectile and find looks one up. The first half of the
+// frames settle the population and are not measured
+template<typename Handle, typename Spawn, typename Despawn, typename Each, typename Find>
+static Result churn(int frames, uint32_t population, uint32_t spawned, Spawn spawn, Despawn despawn, Each each, Find find) {
+    std::mt19937 rng{1234};
+    std::vector<Handle> live;
+    live.reserve(population + spawned);
+    for (uint32_t i = 0; i < population; i++) {
+        live.push_back(spawn(i));
+    }
+
+    Result result{};
+    uint64_t allocations = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        bool measured = frame >= frames / 2;
+        uint64_t allocations_before = bench_allocation_count();
+        auto start = bench_clock::now();
+
+        for (uint32_t i = 0; i < spawned; i++) {
+            size_t victim = rng() % live.size();
+            despawn(live[victim]);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+        for (uint32_t i = 0; i < spawned; i++) {
+            live.push_back(spawn(i));
+        }
+        each([](Projectile& projectile) { projectile.position += projectile.velocity * (1.f / 60.f); });
+        for (uint32_t i = 0; i < spawned; i++) {
+            result.checksum += find(live[rng() % live.size()]).position.x;
+        }
+
+        if (measured) {
+            result.ms += elapsed_ms(start);
+            allocations += bench_allocation_count() - allocations_before;
+        }
+    }
+
+    int measured_frames = frames - frames / 2;
+    result.ms /= measured_frames;
+    result.allocations = static_cast<double>(allocations) / measured_frames;
+    return result;
+}
+
+static Projectile make_projectile(uint32_t i) {
+    return Projectile{glm::vec3{0.f}, glm::vec3{static_cast<float>(i % 7), 1.f, 0.f}};
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 400;
+    uint32_t population = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 20000;
+    uint32_t spawned = argc > 3 ? static_cast<uint32_t>(std::atoi(argv[3])) : 1000;
+
+    std::vector<Old_Object> objects;
+    uint32_t current_id = 0;
+    auto shared_model = std::make_shared<int>(0);
+    Result old_result = churn<uint32_t>(frames, population, spawned,
+        [&](uint32_t i) {
+            objects.push_back(Old_Object{current_id, shared_model, make_projectile(i)});
+            return current_id++;
+        },
+        [&](uint32_t id) {
+            objects.erase(std::find_if(objects.begin(), objects.end(), [id](const Old_Object& object) { return object.id == id; }));
+        },
+        [&](auto&& function) { for (Old_Object& object : objects) function(object.projectile); },
+        [&](uint32_t id) -> Projectile& {
+            return std::find_if(objects.begin(), objects.end(), [id](const Old_Object& object) { return object.id == id; })->projectile;
+        });
+
+    CGE_Slot_Map<Projectile> projectiles;
+    projectiles.reserve(population + spawned);
+    using Handle = CGE_Slot_Map<Projectile>::Handle;
+    Result slot_map_result = churn<Handle>(frames, population, spawned,
+        [&](uint32_t i) { return projectiles.insert(make_projectile(i)); },
+        [&](Handle handle) { projectiles.erase(handle); },
+        [&](auto&& function) { for (Projectile& projectile : projectiles) function(projectile); },
+        [&](Handle handle) -> Projectile& { return *projectiles.get(handle); });
+
+    CGE_World world;
+    world.reserve<Projectile>(population + spawned);
+    Result world_result = churn<CGE_Entity>(frames, population, spawned,
+        [&](uint32_t i) { return world.create(make_projectile(i)); },
+        [&](CGE_Entity entity) { world.destroy(entity); },
+        [&](auto&& function) { world.each<Projectile>([&](CGE_Entity, Projectile& projectile) { function(projectile); }); },
+        [&](CGE_Entity entity) -> Projectile& { return *world.get<Projectile>(entity); });
+
+    std::cout << population << " projectiles, " << spawned << " spawned and despawned per frame" << std::endl;
+    std::cout << "\tvector + ids:  " << old_result.ms << " ms/frame, "
+              << old_result.allocations << " allocations/frame" << std::endl;
+    std::cout << "\tCGE_Slot_Map:  " << slot_map_result.ms << " ms/frame, "
+              << slot_map_result.allocations << " allocations/frame" << std::endl;
+    std::cout << "\tCGE_World:     " << world_result.ms << " ms/frame, "
+              << world_result.allocations << " allocations/frame" << std::endl;
+    std::cout << "\tchecksums " << old_result.checksum << " / " << slot_map_result.checksum
+              << " / " << world_result.checksum << std::endl;
+
+    return 0;
+}
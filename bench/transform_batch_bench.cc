@@ -0,0 +1,106 @@
+// Batch transform kernel: model and normal matrices of moving objects
+// computed one at a time with TransformComponent::compose against
+// cge_compose_transforms at every SIMD level the CPU supports. Also reports
+// the largest difference from compose, which should stay around 1e-6.
+//
+// Usage: bin/transform_batch_bench [iterations] [objects]
+#include "bench_utils.hh"
+#include "cge_game_object.hh"
+#include "cge_transform_batch.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using cge::CGE_Simd_Level;
+using cge::TransformComponent;
+
+static float max_difference(const float* a, const float* b, size_t count) {
+    float difference = 0.f;
+    for (size_t i = 0; i < count; i++) {
+        difference = std::max(difference, std::fabs(a[i] - b[i]));
+    }
+    return difference;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 100;
+    uint32_t objects = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 50003;
+
+    // Structure of arrays input; angles cover several turns both ways
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> position{-100.f, 100.f};
+    std::uniform_real_distribution<float> angle{-20.f, 20.f};
+    std::uniform_real_distribution<float> size{0.25f, 4.f};
+    std::vector<std::vector<float>> values(9, std::vector<float>(objects));
+    for (uint32_t i = 0; i < objects; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            values[axis][i] = position(rng);
+            values[3 + axis][i] = angle(rng);
+            values[6 + axis][i] = size(rng);
+        }
+    }
+
+    cge::CGE_Transform_SoA soa{};
+    for (int axis = 0; axis < 3; axis++) {
+        soa.translation[axis] = values[axis].data();
+        soa.rotation[axis] = values[3 + axis].data();
+        soa.scale[axis] = values[6 + axis].data();
+    }
+
+    std::vector<glm::mat4> reference_matrices(objects);
+    std::vector<glm::mat3> reference_normals(objects);
+    double reference_ms = 0.0;
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        auto start = bench_clock::now();
+        for (uint32_t i = 0; i < objects; i++) {
+            TransformComponent::compose(
+                {values[0][i], values[1][i], values[2][i]},
+                {values[6][i], values[7][i], values[8][i]},
+                {values[3][i], values[4][i], values[5][i]},
+                reference_matrices[i],
+                reference_normals[i]);
+        }
+        reference_ms += elapsed_ms(start);
+    }
+    reference_ms /= iterations;
+
+    std::cout << objects << " transforms, " << iterations << " iterations" << std::endl;
+    std::cout << "\tcompose:          " << reference_ms << " ms" << std::endl;
+
+    bool accurate = true;
+    std::vector<glm::mat4> matrices(objects);
+    std::vector<glm::mat3> normals(objects);
+    for (uint32_t level = 0; level <= static_cast<uint32_t>(cge::cge_supported_simd_level()); level++) {
+        cge::cge_set_transform_simd_level(static_cast<CGE_Simd_Level>(level));
+
+        double batch_ms = 0.0;
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            auto start = bench_clock::now();
+            cge::cge_compose_transforms(soa, objects, matrices.data(), normals.data());
+            batch_ms += elapsed_ms(start);
+        }
+        batch_ms /= iterations;
+
+        float matrix_error = max_difference(
+            reinterpret_cast<const float*>(matrices.data()),
+            reinterpret_cast<const float*>(reference_matrices.data()),
+            objects * 16);
+        float normal_error = max_difference(
+            reinterpret_cast<const float*>(normals.data()),
+            reinterpret_cast<const float*>(reference_normals.data()),
+            objects * 9);
+        // Translations reach 100, so allow a few ulps at that magnitude
+        accurate = accurate && matrix_error < 1e-4f && normal_error < 1e-4f;
+
+        std::cout << "\tbatch " << cge::cge_simd_level_name(static_cast<CGE_Simd_Level>(level)) << ": "
+                  << batch_ms << " ms (" << reference_ms / batch_ms << "x), max error "
+                  << matrix_error << " / " << normal_error << std::endl;
+    }
+    cge::cge_set_transform_simd_level(cge::cge_supported_simd_level());
+
+    return accurate ? 0 : 1;
+}
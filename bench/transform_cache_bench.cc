@@ -0,0 +1,113 @@
+// Transform cost of a mostly static scene: recomputing every model and
+// normal matrix each frame (what TransformComponent did before caching)
+// against the cached matrices, which only rebuild objects that moved.
+//
+// Usage: bin/transform_cache_bench [frames] [objects] [moving percent]
+#include "bench_utils.hh"
+#include "cge_ecs.hh"
+#include "cge_game_object.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using cge::CGE_Entity;
+using cge::CGE_World;
+using cge::TransformComponent;
+
+static void create_scene(CGE_World& world, uint32_t objects) {
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> position{-100.f, 100.f};
+    std::uniform_real_distribution<float> angle{0.f, 6.2831853f};
+    std::uniform_real_distribution<float> size{0.5f, 2.f};
+
+    world.reserve<TransformComponent>(objects);
+    for (uint32_t i = 0; i < objects; i++) {
+        world.create(TransformComponent{
+            {position(rng), position(rng), position(rng)},
+            glm::vec3{size(rng)},
+            {angle(rng), angle(rng), angle(rng)}});
+    }
+}
+
+// Nudge every move_stride-th object, as gameplay would through the setters
+static void move_objects(CGE_World& world, uint32_t move_stride, uint32_t frame) {
+    float offset = (frame & 1) ? 0.01f : -0.01f;
+    world.each_chunk<TransformComponent>([&](uint32_t count, const CGE_Entity*, TransformComponent* transforms) {
+        for (uint32_t i = 0; i < count; i += move_stride) {
+            transforms[i].translate(glm::vec3{offset, 0.f, 0.f});
+            transforms[i].set_rotation(transforms[i].get_rotation() + glm::vec3{0.f, offset, 0.f});
+        }
+    });
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 200;
+    uint32_t objects = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 50000;
+    float moving_percent = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 1.f;
+
+    uint32_t move_stride = moving_percent > 0.f
+        ? std::max<uint32_t>(1, static_cast<uint32_t>(100.f / moving_percent))
+        : objects + 1;
+
+    // Consumes the matrices so neither loop can be optimized away
+    double uncached_checksum = 0.0;
+    double uncached_ms = 0.0;
+    {
+        CGE_World world;
+        create_scene(world, objects);
+        for (int frame = 0; frame < frames; frame++) {
+            move_objects(world, move_stride, frame);
+
+            auto start = bench_clock::now();
+            world.each_chunk<TransformComponent>([&](uint32_t count, const CGE_Entity*, TransformComponent* transforms) {
+                for (uint32_t i = 0; i < count; i++) {
+                    glm::mat4 matrix;
+                    glm::mat3 normal_matrix;
+                    TransformComponent::compose(
+                        transforms[i].get_translation(),
+                        transforms[i].get_scale(),
+                        transforms[i].get_rotation(),
+                        matrix,
+                        normal_matrix);
+                    uncached_checksum += matrix[0][0] + matrix[3][0] + normal_matrix[2][2];
+                }
+            });
+            uncached_ms += elapsed_ms(start);
+        }
+    }
+
+    double cached_checksum = 0.0;
+    double cached_ms = 0.0;
+    {
+        CGE_World world;
+        create_scene(world, objects);
+        for (int frame = 0; frame < frames; frame++) {
+            move_objects(world, move_stride, frame);
+
+            auto start = bench_clock::now();
+            world.each_chunk<TransformComponent>([&](uint32_t count, const CGE_Entity*, TransformComponent* transforms) {
+                for (uint32_t i = 0; i < count; i++) {
+                    const glm::mat4& matrix = transforms[i].mat4();
+                    const glm::mat3& normal_matrix = transforms[i].normalMatrix();
+                    cached_checksum += matrix[0][0] + matrix[3][0] + normal_matrix[2][2];
+                }
+            });
+            cached_ms += elapsed_ms(start);
+        }
+    }
+
+    uncached_ms /= frames;
+    cached_ms /= frames;
+
+    std::cout << objects << " objects, " << moving_percent << "% moving, " << frames << " frames" << std::endl;
+    std::cout << "\trecomputed: " << uncached_ms << " ms/frame" << std::endl;
+    std::cout << "\tcached:     " << cached_ms << " ms/frame ("
+              << uncached_ms / cached_ms << "x)" << std::endl;
+    if (uncached_checksum != cached_checksum) {
+        std::cout << "\tchecksum mismatch: " << uncached_checksum << " != " << cached_checksum << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Geometry upload time against model count:
+//   per buffer  - staging buffer + CGE_Device::copyBuffer for the vertex and
+//                 index buffer, i.e. two blocking submits per model (the old path)
+//   per model   - CGE_Model without a batcher, one blocking submit per model
+//   batched     - every model recorded into one CGE_Upload_Batcher, one submit
+// Opens a window since CGE_Device needs a surface.
+//
+// Usage: bin/upload_batch_bench [model.obj] [count ...]
+#include "bench_utils.hh"
+#include "cge_window.hh"
+#include "cge_device.hh"
+#include "cge_buffer.hh"
+#include "cge_model.hh"
+#include "cge_upload_batcher.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using cge::CGE_Buffer;
+using cge::CGE_Model;
+
+// What CGE_Model used to do for each of its buffers
+static std::unique_ptr<CGE_Buffer> upload_blocking(
+    cge::CGE_Device& device,
+    const void* data,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage
+) {
+    CGE_Buffer staging_buffer{
+        device,
+        size,
+        1,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    };
+    staging_buffer.map();
+    staging_buffer.write_to_buffer(const_cast<void*>(data));
+
+    auto buffer = std::make_unique<CGE_Buffer>(
+        device,
+        size,
+        1,
+        usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    );
+    device.copyBuffer(staging_buffer.get_buffer(), buffer->get_buffer(), size);
+    return buffer;
+}
+
+int main(int argc, char** argv) {
+    std::string model = argc > 1 ? argv[1] : "models/smooth_vase.obj";
+    std::vector<int> counts;
+    for (int i = 2; i < argc; i++) {
+        counts.push_back(std::atoi(argv[i]));
+    }
+    if (counts.empty()) {
+        counts = {1, 10, 100, 500};
+    }
+
+    CGE_Model::Builder builder{};
+    builder.write_cache = false;
+    builder.lod_settings.ratios.clear();
+    builder.load_models(model);
+    CGE_Model::Mesh_View mesh = builder.view();
+
+    cge::CGE_Window window{320, 240, "upload_batch_bench"};
+    cge::CGE_Device device{window};
+
+    std::cout << model << " (" << mesh.vertex_count << " vertices, "
+              << mesh.index_count << " indices)" << std::endl;
+
+    for (int count : counts) {
+        std::vector<std::unique_ptr<CGE_Buffer>> buffers;
+        auto start = bench_clock::now();
+        for (int i = 0; i < count; i++) {
+            buffers.push_back(upload_blocking(
+                device, mesh.vertices, mesh.vertex_count * sizeof(CGE_Model::Vertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT));
+            buffers.push_back(upload_blocking(
+                device, mesh.indices, mesh.index_count * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT));
+        }
+        double per_buffer_ms = elapsed_ms(start);
+        buffers.clear();
+
+        std::vector<std::unique_ptr<CGE_Model>> models;
+        start = bench_clock::now();
+        for (int i = 0; i < count; i++) {
+            models.push_back(std::make_unique<CGE_Model>(device, mesh));
+        }
+        double per_model_ms = elapsed_ms(start);
+        models.clear();
+
+        start = bench_clock::now();
+        {
+            cge::CGE_Upload_Batcher batcher{device};
+            for (int i = 0; i < count; i++) {
+                models.push_back(std::make_unique<CGE_Model>(device, mesh, cge::CGE_Vertex_Format::FULL, &batcher));
+            }
+            batcher.flush();
+        }
+        double batched_ms = elapsed_ms(start);
+        models.clear();
+
+        std::cout << count << " models" << std::endl;
+        std::cout << "\tper buffer: " << per_buffer_ms << " ms" << std::endl;
+        std::cout << "\tper model:  " << per_model_ms << " ms" << std::endl;
+        std::cout << "\tbatched:    " << batched_ms << " ms" << std::endl;
+        std::cout << "\tspeedup:    " << per_buffer_ms / batched_ms << "x" << std::endl;
+    }
+
+    vkDeviceWaitIdle(device.device());
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Vertex dedup throughput: the previous node-based std::unordered_map
+// (count + operator[], glm hash_combine) against CGE_Vertex_Map.
+//
+// Usage: bin/vertex_dedup_bench [iterations] [model.obj ...]
+#include "bench_utils.hh"
+#include "cge_model.hh"
+#include "cge_obj_loader.hh"
+#include "cge_vertex_map.hh"
+#include "utils.hh"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace std {
+    template<>
+    struct hash<cge::CGE_Model::Vertex> {
+        size_t operator()(cge::CGE_Model::Vertex const &vertex) const {
+            size_t seed = 0;
+            cge::hash_combine(seed, vertex.position, vertex.color, vertex.normals, vertex.uv);
+            return seed;
+        }
+    };
+} // std
+
+using cge::CGE_Model;
+
+// Expand every triangle corner to a full vertex, the input both dedup paths see
+static std::vector<CGE_Model::Vertex> expand_corners(const cge::CGE_Obj_Data& obj) {
+    std::vector<CGE_Model::Vertex> corners;
+    corners.reserve(obj.corners.size());
+    for (const auto& corner : obj.corners) {
+        CGE_Model::Vertex vertex{};
+        if (corner.position >= 0) {
+            const float* p = &obj.positions[3 * corner.position];
+            const float* c = &obj.colors[3 * corner.position];
+            vertex.position = {p[0], p[1], p[2]};
+            vertex.color = {c[0], c[1], c[2]};
+        }
+        if (corner.normal >= 0) {
+            const float* n = &obj.normals[3 * corner.normal];
+            vertex.normals = {n[0], n[1], n[2]};
+        }
+        if (corner.texcoord >= 0) {
+            const float* t = &obj.texcoords[2 * corner.texcoord];
+            vertex.uv = {t[1], t[0]};
+        }
+        corners.push_back(vertex);
+    }
+    return corners;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+    std::vector<std::string> models;
+    for (int i = 2; i < argc; i++) {
+        models.push_back(argv[i]);
+    }
+    if (models.empty()) {
+        models = {"models/smooth_vase.obj", "models/flat_vase.obj"};
+    }
+
+    for (const auto& model : models) {
+        cge::CGE_Obj_Data obj{};
+        cge::CGE_Obj_Loader::load(model, obj);
+        auto corners = expand_corners(obj);
+
+        size_t map_unique = 0;
+        double map_ms = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            std::vector<CGE_Model::Vertex> vertices;
+            std::vector<uint32_t> indices;
+            indices.reserve(corners.size());
+
+            auto start = bench_clock::now();
+            std::unordered_map<CGE_Model::Vertex, uint32_t> unique_vertices{};
+            for (const auto& vertex : corners) {
+                if (unique_vertices.count(vertex) == 0) {
+                    unique_vertices[vertex] = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back(vertex);
+                }
+                indices.push_back(unique_vertices[vertex]);
+            }
+            map_ms += elapsed_ms(start);
+            map_unique = vertices.size();
+        }
+
+        size_t flat_unique = 0;
+        double flat_ms = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            std::vector<CGE_Model::Vertex> vertices;
+            std::vector<uint32_t> indices;
+            indices.reserve(corners.size());
+
+            auto start = bench_clock::now();
+            cge::CGE_Vertex_Map unique_vertices{corners.size()};
+            for (const auto& vertex : corners) {
+                indices.push_back(unique_vertices.find_or_insert(vertex, vertices));
+            }
+            flat_ms += elapsed_ms(start);
+            flat_unique = vertices.size();
+        }
+
+        map_ms /= iterations;
+        flat_ms /= iterations;
+        double corner_millions = corners.size() / 1e6;
+
+        std::cout << model << " (" << corners.size() << " corners)" << std::endl;
+        std::cout << "\tstd::unordered_map: " << map_ms << " ms, "
+                  << corner_millions / (map_ms / 1000.0) << " Mvert/s, " << map_unique << " unique" << std::endl;
+        std::cout << "\tCGE_Vertex_Map:     " << flat_ms << " ms, "
+                  << corner_millions / (flat_ms / 1000.0) << " Mvert/s, " << flat_unique << " unique" << std::endl;
+        std::cout << "\tspeedup:            " << map_ms / flat_ms << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -2,6 +2,8 @@
 
 #include "cge_device.hh"
 #include <cstdint>
+#include <utility>
+#include <vector>
 #include <vulkan/vulkan_core.h>
 
 namespace cge {
@@ -14,7 +16,8 @@ namespace cge {
                 uint32_t instance_count,
                 VkBufferUsageFlags flags,
                 VkMemoryPropertyFlags memory_property_flags,
-                VkDeviceSize min_offset_allignment = 1
+                VkDeviceSize min_offset_allignment = 1,
+                VkMemoryPropertyFlags preferred_memory_property_flags = 0
             );
             ~CGE_Buffer();
 
@@ -26,6 +29,14 @@ namespace cge {
 
             void write_to_buffer(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
             VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+            // Record a range written through get_mapped_memory(). write_to_buffer
+            // and write_to_index do this themselves
+            void mark_dirty(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+            // Flush every dirty range in one call, merged and rounded out to
+            // nonCoherentAtomSize. Does nothing for host coherent memory
+            VkResult flush_dirty();
+            size_t get_dirty_range_count() const { return _dirty_ranges.size(); }
             VkDescriptorBufferInfo descriptor_info(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
             VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 
@@ -40,16 +51,23 @@ namespace cge {
             VkDeviceSize get_instance_size() const { return _instance_size; }
             VkDeviceSize get_allignment_size() const { return _alignment_size; }
             VkBufferUsageFlags get_usage_flags() const { return _usage_flags; }
+            // Flags of the memory type actually chosen, a superset of the requested ones
             VkMemoryPropertyFlags get_memory_property_flags() const { return _memory_property_flags; }
+            bool is_host_visible() const { return _memory.mapped != nullptr; }
             VkDeviceSize get_buffer_size() const { return _buffer_size; }
+            // Shader visible address, or 0 unless the buffer was created with
+            // VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT on a device that supports it
+            VkDeviceAddress get_device_address() const { return _device_address; }
 
         private:
             static VkDeviceSize get_allignment(VkDeviceSize instance_size, VkDeviceSize min_offset_allignment);
+            VkMappedMemoryRange _memory_range(VkDeviceSize size, VkDeviceSize offset) const;
+            bool _is_coherent() const { return _memory_property_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT; }
 
             CGE_Device& _device;
             void* _mapped = nullptr;
             VkBuffer _buffer = VK_NULL_HANDLE;
-            VkDeviceMemory _memory = VK_NULL_HANDLE;
+            CGE_Allocation _memory;
 
             VkDeviceSize _buffer_size;
             uint32_t _instance_count;
@@ -57,6 +75,12 @@ namespace cge {
             VkDeviceSize _alignment_size;
             VkBufferUsageFlags _usage_flags;
             VkMemoryPropertyFlags _memory_property_flags;
+            VkDeviceAddress _device_address = 0;
+
+            // Written but unflushed [begin, end) byte ranges, and scratch for
+            // the merged ranges so flushing does not allocate every frame
+            std::vector<std::pair<VkDeviceSize, VkDeviceSize>> _dirty_ranges;
+            std::vector<VkMappedMemoryRange> _flush_ranges;
     };
 
 } // cge
@@ -3,9 +3,12 @@
 #define CGE_DEVICE
 
 #include "cge_window.hh"
+#include "cge_memory_allocator.hh"
+#include "cge_staging_ring.hh"
 // #include "cge_swap_chain.hh"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 #include <vulkan/vulkan.h>
@@ -21,8 +24,11 @@ namespace cge {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        // Family other than graphics for staging copies, dedicated DMA preferred
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool transferFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
     
@@ -48,20 +54,30 @@ namespace cge {
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        // Same as graphicsQueue() when the device has no separate transfer family
+        VkQueue transferQueue() { return transferQueue_; }
+        uint32_t transferQueueFamily() { return transferFamily_; }
+        bool hasSeparateTransferQueue() { return transferQueue_ != graphicsQueue_; }
     
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
-        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        // Ranked by CGE_Memory_Allocator::find_memory_type
+        uint32_t findMemoryType(
+                uint32_t typeFilter,
+                VkMemoryPropertyFlags properties,
+                VkMemoryPropertyFlags preferredProperties = 0);
         QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
         VkFormat findSupportedFormat(
                 const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
     
         // Buffer Helper Functions
+        // Memory comes from memoryAllocator() and is released with freeMemory()
         void createBuffer(
                 VkDeviceSize size,
                 VkBufferUsageFlags usage,
                 VkMemoryPropertyFlags properties,
                 VkBuffer &buffer,
-                VkDeviceMemory &bufferMemory);
+                CGE_Allocation &bufferMemory,
+                VkMemoryPropertyFlags preferredProperties = 0);
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -72,9 +88,29 @@ namespace cge {
                 const VkImageCreateInfo &imageInfo,
                 VkMemoryPropertyFlags properties,
                 VkImage &image,
-                VkDeviceMemory &imageMemory);
+                CGE_Allocation &imageMemory);
+        void freeMemory(const CGE_Allocation &allocation) { allocator_->free(allocation); }
+
+        CGE_Memory_Allocator &memoryAllocator() { return *allocator_; }
+        // Current use per heap and category. Heap usage and budget come from
+        // VK_EXT_memory_budget when the device supports it
+        CGE_Memory_Snapshot memorySnapshot();
+        bool memoryBudgetSupported() { return memoryBudgetSupported_; }
+
+        // VK_KHR_buffer_device_address, enabled when the device has it.
+        // Only buffers created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+        // have an address
+        bool bufferDeviceAddressSupported() { return bufferDeviceAddressSupported_; }
+        VkDeviceAddress getBufferDeviceAddress(VkBuffer buffer);
+
+        // Shared staging memory for uploads recorded on the transfer queue
+        static constexpr VkDeviceSize STAGING_RING_SIZE = 32 * 1024 * 1024;
+        CGE_Staging_Ring &stagingRing() { return *stagingRing_; }
     
         VkPhysicalDeviceProperties properties;
+
+        // Optional features that were available and enabled on the logical device
+        VkPhysicalDeviceFeatures features{};
     
      private:
         void createInstance();
@@ -92,6 +128,7 @@ namespace cge {
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char *name);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
@@ -104,6 +141,13 @@ namespace cge {
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        uint32_t transferFamily_;
+        bool memoryBudgetSupported_ = false;
+        bool bufferDeviceAddressSupported_ = false;
+        PFN_vkGetBufferDeviceAddressKHR getBufferDeviceAddress_ = nullptr;
+        std::unique_ptr<CGE_Memory_Allocator> allocator_;
+        std::unique_ptr<CGE_Staging_Ring> stagingRing_;
 
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
@@ -0,0 +1,296 @@
+#pragma once
+#ifndef CGE_ECS
+#define CGE_ECS
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cge {
+
+    // Handle to an entity in a CGE_World. The generation changes every time
+    // an index is reused, so handles to destroyed entities stay invalid
+    struct CGE_Entity {
+        static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+        uint32_t index = INVALID;
+        uint32_t generation = 0;
+
+        bool valid() const { return index != INVALID; }
+        bool operator==(const CGE_Entity& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const CGE_Entity& other) const { return !(*this == other); }
+    };
+
+    // Type-erased operations on one component type, so archetypes can store
+    // and move any component in raw columns
+    struct CGE_Component_Info {
+        size_t size = 0;
+        size_t alignment = 0;
+        // memcpy is a valid move and nothing needs destroying
+        bool trivial = false;
+        // Move construct dst from src, leaving src to be destroyed
+        void (*move_construct)(void* dst, void* src) = nullptr;
+        void (*destroy)(void* component) = nullptr;
+    };
+
+    // Components are numbered in the order they are first used. A world
+    // supports up to CGE_MAX_COMPONENTS distinct types
+    static constexpr uint32_t CGE_MAX_COMPONENTS = 64;
+
+    uint32_t cge_register_component(const CGE_Component_Info& info);
+    const CGE_Component_Info& cge_component_info(uint32_t component);
+
+    template<typename T>
+    uint32_t cge_component_id() {
+        static_assert(std::is_nothrow_move_constructible<T>::value, "components must be nothrow move constructible");
+
+        static const uint32_t id = cge_register_component(CGE_Component_Info{
+            sizeof(T),
+            alignof(T),
+            std::is_trivially_copyable<T>::value,
+            [](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); },
+            [](void* component) { static_cast<T*>(component)->~T(); }
+        });
+        return id;
+    }
+
+    template<typename... Components>
+    uint64_t cge_component_mask() {
+        return (uint64_t{0} | ... | (uint64_t{1} << cge_component_id<Components>()));
+    }
+
+    // Every entity with exactly one set of components, stored as one array per
+    // component (structure of arrays). Row i of every column and of
+    // get_entities() belongs to the same entity. Removing a row moves the
+    // last row into its place, so rows are only stable until the next
+    // structural change of the world
+    class CGE_Archetype {
+        public:
+            CGE_Archetype(uint64_t mask);
+            ~CGE_Archetype();
+
+            CGE_Archetype(const CGE_Archetype&) = delete;
+            CGE_Archetype& operator=(const CGE_Archetype&) = delete;
+
+            uint64_t get_mask() const { return _mask; }
+            uint32_t size() const { return static_cast<uint32_t>(_entities.size()); }
+            const CGE_Entity* get_entities() const { return _entities.data(); }
+
+            bool has(uint32_t component) const { return (_mask >> component) & 1u; }
+
+            // Column of a component in the archetype's mask
+            template<typename T>
+            T* column() {
+                assert(has(cge_component_id<T>()) && "Archetype does not have this component");
+                return reinterpret_cast<T*>(_column(cge_component_id<T>()).data);
+            }
+
+            void reserve(uint32_t capacity);
+
+            // Append a row for entity. Its components are left unconstructed
+            // and must be constructed through _component before anything else
+            // touches the archetype
+            uint32_t _push(CGE_Entity entity);
+            void* _component(uint32_t component, uint32_t row) {
+                Column& column = _column(component);
+                return column.data + static_cast<size_t>(row) * column.info->size;
+            }
+            // Destroy the row's components in destroy_mask and move the last
+            // row into its place. Components outside the mask must already have
+            // been moved out and destroyed. Returns the entity that moved, or an
+            // invalid entity if row was the last one
+            CGE_Entity _swap_remove(uint32_t row, uint64_t destroy_mask = ~uint64_t{0});
+
+        private:
+            struct Column {
+                uint32_t component = 0;
+                const CGE_Component_Info* info = nullptr;
+                unsigned char* data = nullptr;
+            };
+
+            Column& _column(uint32_t component) { return _columns[_column_index[component]]; }
+
+            uint64_t _mask;
+            std::vector<Column> _columns;
+            uint8_t _column_index[CGE_MAX_COMPONENTS] = {};
+            std::vector<CGE_Entity> _entities;
+            uint32_t _capacity = 0;
+    };
+
+    // Entities and their components. Components are plain structs with no
+    // registration; each distinct set of components gets its own archetype.
+    // Adding or removing a component moves the entity to the archetype of
+    // the new set.
+    //
+    // Systems iterate with each() or each_chunk(), which visit every
+    // archetype that has the requested components and hand over only those
+    // columns. Creating, destroying or changing the components of entities
+    // is not allowed while iterating
+    class CGE_World {
+        public:
+            CGE_World();
+            ~CGE_World();
+
+            CGE_World(const CGE_World&) = delete;
+            CGE_World& operator=(const CGE_World&) = delete;
+
+            // Create an entity with the given components, constructed directly
+            // in their final archetype
+            template<typename... Components>
+            CGE_Entity create(Components&&... components) {
+                assert(_iterating == 0 && "Cannot create entities while iterating");
+                CGE_Archetype& archetype = _archetype(cge_component_mask<std::decay_t<Components>...>());
+                CGE_Entity entity = _allocate_entity(archetype);
+                uint32_t row = _records[entity.index].row;
+                (new (archetype._component(cge_component_id<std::decay_t<Components>>(), row))
+                    std::decay_t<Components>(std::forward<Components>(components)), ...);
+                return entity;
+            }
+
+            void destroy(CGE_Entity entity);
+            bool alive(CGE_Entity entity) const {
+                return entity.index < _records.size() && _records[entity.index].generation == entity.generation
+                    && _records[entity.index].archetype;
+            }
+
+            // Make room for count more entities with exactly these components,
+            // so creating and destroying up to that many does not allocate
+            template<typename... Components>
+            void reserve(uint32_t count) {
+                CGE_Archetype& archetype = _archetype(cge_component_mask<Components...>());
+                archetype.reserve(archetype.size() + count);
+                _records.reserve(_alive_count + count);
+                _structure_version++;
+            }
+
+            // Add a component, or replace the existing one
+            template<typename T, typename... Args>
+            T& add(CGE_Entity entity, Args&&... args) {
+                assert(alive(entity) && "Entity is not alive");
+                uint32_t component = cge_component_id<T>();
+                Record& record = _records[entity.index];
+
+                if (record.archetype->has(component)) {
+                    // Replacing a component is not a structural change
+                    T* existing = static_cast<T*>(record.archetype->_component(component, record.row));
+                    *existing = T(std::forward<Args>(args)...);
+                    return *existing;
+                }
+
+                assert(_iterating == 0 && "Cannot add components while iterating");
+                _move_entity(entity, record.archetype->get_mask() | (uint64_t{1} << component));
+                void* memory = record.archetype->_component(component, record.row);
+                return *new (memory) T(std::forward<Args>(args)...);
+            }
+
+            template<typename T>
+            void remove(CGE_Entity entity) {
+                assert(alive(entity) && "Entity is not alive");
+                uint32_t component = cge_component_id<T>();
+                const Record& record = _records[entity.index];
+                if (record.archetype->has(component)) {
+                    assert(_iterating == 0 && "Cannot remove components while iterating");
+                    _move_entity(entity, record.archetype->get_mask() & ~(uint64_t{1} << component));
+                }
+            }
+
+            template<typename T>
+            bool has(CGE_Entity entity) const {
+                return alive(entity) && _records[entity.index].archetype->has(cge_component_id<T>());
+            }
+
+            // nullptr when the entity does not have the component. The pointer
+            // is valid until the next structural change
+            template<typename T>
+            T* get(CGE_Entity entity) {
+                if (!has<T>(entity))
+                    return nullptr;
+                const Record& record = _records[entity.index];
+                return static_cast<T*>(record.archetype->_component(cge_component_id<T>(), record.row));
+            }
+
+            // function(count, entities, Components*... columns) once per
+            // non-empty archetype with all the components
+            template<typename... Components, typename Function>
+            void each_chunk(Function&& function) {
+                uint64_t mask = cge_component_mask<Components...>();
+                _iterating++;
+                for (CGE_Archetype* archetype : _archetypes) {
+                    if ((archetype->get_mask() & mask) != mask || archetype->size() == 0)
+                        continue;
+                    function(archetype->size(), archetype->get_entities(), archetype->column<Components>()...);
+                }
+                _iterating--;
+            }
+
+            // Column of an optional component inside each_chunk: chunk_entities
+            // is the entities array of the chunk, and the result is nullptr
+            // when that archetype does not have T
+            template<typename T>
+            T* optional_column(const CGE_Entity* chunk_entities) {
+                CGE_Archetype* archetype = _records[chunk_entities[0].index].archetype;
+                assert(archetype->get_entities() == chunk_entities && "Not the entities of a chunk");
+                return archetype->has(cge_component_id<T>()) ? archetype->column<T>() : nullptr;
+            }
+
+            // function(entity, Components&... components) for every entity
+            // with all the components
+            template<typename... Components, typename Function>
+            void each(Function&& function) {
+                each_chunk<Components...>([&](uint32_t count, const CGE_Entity* entities, Components*... columns) {
+                    for (uint32_t i = 0; i < count; i++) {
+                        function(entities[i], columns[i]...);
+                    }
+                });
+            }
+
+            // Number of entities with all the components
+            template<typename... Components>
+            uint32_t count() const {
+                uint64_t mask = cge_component_mask<Components...>();
+                uint32_t total = 0;
+                for (const CGE_Archetype* archetype : _archetypes) {
+                    if ((archetype->get_mask() & mask) == mask) {
+                        total += archetype->size();
+                    }
+                }
+                return total;
+            }
+
+            uint32_t size() const { return _alive_count; }
+            uint32_t get_archetype_count() const { return static_cast<uint32_t>(_archetypes.size()); }
+
+            // Changes whenever components may have moved in memory, so a
+            // system can keep component pointers while it stays the same
+            uint64_t get_structure_version() const { return _structure_version; }
+
+        private:
+            struct Record {
+                CGE_Archetype* archetype = nullptr;     // nullptr once destroyed
+                uint32_t row = 0;                       // next free index once destroyed
+                uint32_t generation = 0;
+            };
+
+            CGE_Archetype& _archetype(uint64_t mask);
+            CGE_Entity _allocate_entity(CGE_Archetype& archetype);
+            void _move_entity(CGE_Entity entity, uint64_t mask);
+
+            std::unordered_map<uint64_t, std::unique_ptr<CGE_Archetype>> _archetypes_by_mask;
+            std::vector<CGE_Archetype*> _archetypes;    // in creation order
+
+            std::vector<Record> _records;               // indexed by CGE_Entity::index
+            uint32_t _free_head = CGE_Entity::INVALID;   // destroyed indices, linked through Record::row
+            uint32_t _alive_count = 0;
+            uint32_t _iterating = 0;
+            uint64_t _structure_version = 0;
+    };
+
+} // cge
+
+#endif /* CGE_ECS */
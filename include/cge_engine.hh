@@ -9,7 +9,12 @@
 #include "cge_device.hh"
 #include "cge_window.hh"
 #include "cge_renderer.hh"
+#include "cge_ecs.hh"
 #include "cge_game_object.hh"
+#include "cge_scene_graph.hh"
+#include "cge_model_loader.hh"
+#include "cge_geometry_pool.hh"
+#include "cge_frame_ring.hh"
 
 
 
@@ -26,6 +31,14 @@ namespace cge {
             void _run();
             static constexpr int WIDTH = 800;
             static constexpr int HEIGHT = 600;
+            // Bytes of uniform, storage and indirect data per frame in flight
+            static constexpr VkDeviceSize FRAME_RING_SIZE = 4 * 1024 * 1024;
+            // Seconds between GPU memory reports on stdout, 0 to disable
+            static constexpr float MEMORY_REPORT_INTERVAL = 10.f;
+
+            // GPU memory use right now. Taken on demand rather than every
+            // frame, since a snapshot allocates and locks the allocator
+            CGE_Memory_Snapshot get_memory_snapshot() { return this->_device.memorySnapshot(); }
 
 //            // Create a cube model with an index buffer
 //            // TODO: remove this and load models
@@ -84,8 +97,14 @@ namespace cge {
             CGE_Window _window = CGE_Window(WIDTH, HEIGHT, "Chorus Engine");
             CGE_Device _device {_window};
             CGE_Renderer _renderer {this->_window, this->_device};
+            CGE_Frame_Ring _frame_ring {this->_device, FRAME_RING_SIZE};
+            // Shared vertex and index buffers for every streamed model
+            CGE_Geometry_Pool _geometry_pool {this->_device};
+            CGE_Model_Loader _model_loader {this->_device, &this->_geometry_pool};
             std::unique_ptr<CGE_Model> _model;
-            std::vector<CGE_Game_Object> _game_objects;
+            CGE_World _world;
+            // Parent links between entities of _world; empty unless a scene attaches objects
+            CGE_Scene_Graph _scene_graph;
     };
 }
 
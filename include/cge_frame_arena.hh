@@ -0,0 +1,99 @@
+#pragma once
+#ifndef CGE_FRAME_ARENA
+#define CGE_FRAME_ARENA
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace cge {
+
+    // Bump allocator for CPU data that only lives for a frame: draw lists,
+    // sort keys, culled object lists, matrices. There is one partition per
+    // frame in flight, reset when the renderer begins that frame, so data
+    // from the previous frame stays valid while the next one is built.
+    // Nothing is freed individually.
+    //
+    // Partitions are reserved up front and optionally backed by transparent
+    // huge pages. Requests that do not fit go to the general heap for the
+    // rest of the frame and show up in the stats, so the arena can be sized
+    // until steady state frames never allocate
+    class CGE_Frame_Arena {
+        public:
+            struct Stats {
+                size_t used = 0;                // bytes bumped in the current frame
+                size_t last_frame_used = 0;     // bytes the previous frame used
+                size_t peak_used = 0;           // high water mark over all frames
+                uint32_t overflow_allocations = 0;  // heap fallbacks in the current frame
+                size_t overflow_bytes = 0;
+            };
+
+            static constexpr size_t DEFAULT_CAPACITY = 4 * 1024 * 1024;
+
+            CGE_Frame_Arena(size_t capacity, uint32_t frame_count, bool huge_pages = false);
+            ~CGE_Frame_Arena();
+
+            CGE_Frame_Arena(const CGE_Frame_Arena&) = delete;
+            CGE_Frame_Arena& operator=(const CGE_Frame_Arena&) = delete;
+
+            // Release everything allocated the last time frame_index was used
+            void begin_frame(uint32_t frame_index);
+
+            void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+            template<typename T>
+            T* allocate_array(size_t count) { return static_cast<T*>(allocate(count * sizeof(T), alignof(T))); }
+
+            Stats get_stats() const;
+            size_t get_capacity() const { return _capacity; }
+            bool uses_huge_pages() const { return _huge_pages; }
+
+        private:
+            size_t _capacity;
+            uint32_t _frame_count;
+            bool _huge_pages = false;
+            char* _memory = nullptr;        // _frame_count partitions of _capacity bytes
+            size_t _mapped_size = 0;
+
+            char* _begin = nullptr;         // current partition
+            size_t _head = 0;
+            std::vector<std::vector<void*>> _overflow;  // heap fallbacks per frame
+            uint32_t _frame_index = 0;
+
+            size_t _last_frame_used = 0;
+            size_t _peak_used = 0;
+            size_t _overflow_bytes = 0;
+    };
+
+    // STL allocator that takes its memory from a frame arena. Deallocation
+    // is a no-op, so containers using it must not outlive the frame
+    template<typename T>
+    class CGE_Arena_Allocator {
+        public:
+            using value_type = T;
+
+            CGE_Arena_Allocator(CGE_Frame_Arena& arena) noexcept : _arena{&arena} {}
+            template<typename U>
+            CGE_Arena_Allocator(const CGE_Arena_Allocator<U>& other) noexcept : _arena{other.get_arena()} {}
+
+            T* allocate(size_t count) { return _arena->allocate_array<T>(count); }
+            void deallocate(T*, size_t) noexcept {}
+
+            CGE_Frame_Arena* get_arena() const noexcept { return _arena; }
+
+            template<typename U>
+            bool operator==(const CGE_Arena_Allocator<U>& other) const noexcept { return _arena == other.get_arena(); }
+            template<typename U>
+            bool operator!=(const CGE_Arena_Allocator<U>& other) const noexcept { return _arena != other.get_arena(); }
+
+        private:
+            CGE_Frame_Arena* _arena;
+    };
+
+    template<typename T>
+    using CGE_Frame_Vector = std::vector<T, CGE_Arena_Allocator<T>>;
+
+} // cge
+
+#endif /* CGE_FRAME_ARENA */
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "cge_camera.hh"
+#include "cge_frame_ring.hh"
+#include "cge_frame_arena.hh"
 
 #include <vulkan/vulkan.h>
 
@@ -11,6 +13,10 @@ namespace cge {
         float frame_time;
         VkCommandBuffer command_buffer;
         CGE_Camera& camera;
+        // Per frame memory for uniform, storage and indirect data
+        CGE_Frame_Ring& frame_ring;
+        // Per frame CPU scratch memory, valid until this frame index comes round again
+        CGE_Frame_Arena& frame_arena;
     };
 
 } // cge
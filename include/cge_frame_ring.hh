@@ -0,0 +1,89 @@
+#pragma once
+#ifndef CGE_FRAME_RING
+#define CGE_FRAME_RING
+
+#include "cge_device.hh"
+#include "cge_buffer.hh"
+#include "cge_swap_chain.hh"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+
+namespace cge {
+
+    // One persistently mapped buffer split into a partition per frame in
+    // flight. Systems bump allocate short lived uniform, storage, vertex or
+    // indirect data from the current frame's partition instead of keeping
+    // buffers of their own. A partition is reused once its frame's fence has
+    // signalled, so nothing is created or freed in steady state
+    class CGE_Frame_Ring {
+        public:
+            struct Slice {
+                VkBuffer buffer = VK_NULL_HANDLE;
+                VkDeviceSize offset = 0;
+                VkDeviceSize size = 0;
+                void* data = nullptr;
+
+                bool valid() const { return data != nullptr; }
+
+                // Offset to pass to vkCmdBindDescriptorSets for a dynamic
+                // uniform or storage buffer descriptor
+                uint32_t dynamic_offset() const { return static_cast<uint32_t>(offset); }
+                VkDescriptorBufferInfo descriptor_info() const { return {buffer, offset, size}; }
+            };
+
+            static constexpr VkBufferUsageFlags DEFAULT_USAGE =
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+                | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+            CGE_Frame_Ring(
+                CGE_Device& device,
+                VkDeviceSize frame_size,
+                uint32_t frame_count = CGE_SwapChain::MAX_FRAMES_IN_FLIGHT,
+                VkBufferUsageFlags usage = DEFAULT_USAGE);
+
+            CGE_Frame_Ring(const CGE_Frame_Ring&) = delete;
+            CGE_Frame_Ring& operator=(const CGE_Frame_Ring&) = delete;
+
+            // Start writing into frame_index's partition. Only call once the
+            // renderer has waited for that frame's previous submission
+            void begin_frame(uint32_t frame_index);
+
+            // Reserve size bytes aligned for any descriptor type the ring was
+            // created with. Returns an invalid slice when the partition is full
+            Slice allocate(VkDeviceSize size);
+
+            // allocate() and copy size bytes of data into the slice
+            Slice write(const void* data, VkDeviceSize size);
+
+            // Make this frame's writes visible to the device with one flush of
+            // the allocated slices. Call after recording and before the frame
+            // is submitted
+            void flush();
+
+            VkBuffer get_buffer() const { return _buffer->get_buffer(); }
+            VkDeviceSize get_alignment() const { return _alignment; }
+            VkDeviceSize get_frame_size() const { return _frame_size; }
+            // Bytes allocated from the current partition
+            VkDeviceSize get_used() const { return _head - _frame_begin; }
+            // Most bytes any frame has used, for sizing the ring
+            VkDeviceSize get_peak_used() const { return _peak_used; }
+
+        private:
+            std::unique_ptr<CGE_Buffer> _buffer;
+            VkDeviceSize _alignment;
+            VkDeviceSize _atom_size;
+            VkDeviceSize _frame_size;
+            uint32_t _frame_count;
+
+            VkDeviceSize _frame_begin = 0;
+            VkDeviceSize _head = 0;
+            VkDeviceSize _peak_used = 0;
+    };
+
+} // cge
+
+#endif /* CGE_FRAME_RING */
@@ -3,44 +3,95 @@
 #define CGE_GAME_OBJECT
 
 #include "cge_model.hh"
+#include "cge_ecs.hh"
 #include <glm/gtc/matrix_transform.hpp>
 #include <memory>
 
 namespace cge {
 
+    class CGE_Model_Handle;
+
+    // Translation, scale and Tait-Bryan rotation (Y, X, Z) of an entity.
+    // The matrices are cached and only rebuilt after a setter changed the
+    // transform, so objects that never move are never recomputed
     struct TransformComponent {
-        glm::vec3 translation{};
-        glm::vec3 scale{1.f, 1.f, 1.f};
-        glm::vec3 rotation{};
+        public:
+            TransformComponent() = default;
+            TransformComponent(
+                const glm::vec3& translation,
+                const glm::vec3& scale = glm::vec3{1.f},
+                const glm::vec3& rotation = glm::vec3{0.f});
 
-        glm::mat4 mat4();
-        glm::mat3 normalMatrix();
-    };
+            const glm::vec3& get_translation() const { return _translation; }
+            const glm::vec3& get_scale() const { return _scale; }
+            const glm::vec3& get_rotation() const { return _rotation; }
 
-    class CGE_Game_Object {
-        public:
-            using id_t  = unsigned int;
+            // Setting the current value again does not invalidate the matrices
+            void set_translation(const glm::vec3& translation);
+            void set_scale(const glm::vec3& scale);
+            void set_rotation(const glm::vec3& rotation);
+            void translate(const glm::vec3& delta) { set_translation(_translation + delta); }
 
-            static CGE_Game_Object _create_game_object() {
-                static id_t current_id = 0;
-                return CGE_Game_Object{current_id++};
-            }
+            // Changes every time the transform does
+            uint32_t get_version() const { return _version; }
+            bool is_dirty() const { return _dirty; }
 
-            CGE_Game_Object(const CGE_Game_Object&) = delete;
-            CGE_Game_Object& operator = (const CGE_Game_Object&) = delete;
-            CGE_Game_Object(CGE_Game_Object&&) = default;
-            CGE_Game_Object& operator = (CGE_Game_Object&&) = default;
+            // Cached model and normal matrix, rebuilt together on the first
+            // call after a change
+            const glm::mat4& mat4() {
+                if (_dirty) _update_matrices();
+                return _matrix;
+            }
+            const glm::mat3& normalMatrix() {
+                if (_dirty) _update_matrices();
+                return _normal_matrix;
+            }
 
-            id_t _get_id() {return this->_id;}
+            // Rebuild the matrices of every dirty transform in the array with
+            // the batch kernel (see cge_compose_transforms). Much cheaper than
+            // letting mat4() rebuild them one by one when many objects move
+            static void update_matrices(TransformComponent* transforms, uint32_t count);
 
-            TransformComponent transform{};
-            std::shared_ptr<CGE_Model> model{};
-            glm::vec3 color{};
+            // Build both matrices from scratch, without the cache
+            static void compose(
+                const glm::vec3& translation,
+                const glm::vec3& scale,
+                const glm::vec3& rotation,
+                glm::mat4& matrix,
+                glm::mat3& normal_matrix);
 
         private:
-            CGE_Game_Object(id_t id) : _id(id) {}
+            void _invalidate() { _dirty = true; _version++; }
+            void _update_matrices();
+
+            glm::vec3 _translation{};
+            glm::vec3 _scale{1.f, 1.f, 1.f};
+            glm::vec3 _rotation{};
+
+            glm::mat4 _matrix{1.f};
+            glm::mat3 _normal_matrix{1.f};
+            uint32_t _version = 0;
+            bool _dirty = true;
+    };
+
+    // Game objects are entities of a CGE_World. The components are kept
+    // apart so systems only touch the arrays they use: a movement system
+    // reads transforms without dragging model pointers through the cache
+
+    // Model drawn for the entity
+    struct ModelComponent {
+        std::shared_ptr<CGE_Model> model{};
+
+        // Model still streaming in from CGE_Model_Loader. The render system
+        // draws its bounding box until it is resident, then moves it to model
+        std::shared_ptr<CGE_Model_Handle> pending_model{};
+
+        // Level of detail drawn last frame, kept for hysteresis
+        uint32_t lod = 0;
+    };
 
-            id_t _id;
+    struct ColorComponent {
+        glm::vec3 color{};
     };
 }
 
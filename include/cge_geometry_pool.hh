@@ -0,0 +1,125 @@
+#pragma once
+#ifndef CGE_GEOMETRY_POOL
+#define CGE_GEOMETRY_POOL
+
+#include "cge_device.hh"
+#include "cge_buffer.hh"
+#include "cge_swap_chain.hh"
+#include "cge_vertex_format.hh"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace cge {
+
+    // First-fit free list over a range of elements. Freed ranges are merged
+    // with their neighbours, so fragmentation only comes from live ranges
+    class CGE_Range_Allocator {
+        public:
+            static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+            struct Stats {
+                uint64_t capacity = 0;
+                uint64_t used = 0;
+                uint32_t allocations = 0;
+                uint32_t free_ranges = 0;
+                uint64_t largest_free = 0;
+
+                // Fraction of the pool in use
+                float occupancy() const { return capacity ? static_cast<float>(used) / capacity : 0.f; }
+
+                // 0 when all free space is one range, approaching 1 as it is
+                // split into many small ones
+                float fragmentation() const {
+                    uint64_t free = capacity - used;
+                    return free ? 1.f - static_cast<float>(largest_free) / free : 0.f;
+                }
+            };
+
+            CGE_Range_Allocator(uint32_t capacity);
+
+            // Returns the first element of the range, or INVALID if no free range fits
+            uint32_t allocate(uint32_t count);
+            void free(uint32_t offset, uint32_t count);
+
+            Stats get_stats() const;
+
+        private:
+            std::map<uint32_t, uint32_t> _free_ranges;   // offset -> count
+            uint64_t _capacity;
+            uint32_t _allocations = 0;
+    };
+
+    // One device local vertex buffer and one 32-bit index buffer shared by
+    // every model of a vertex format. Models draw with their base vertex and
+    // first index, so the renderer binds the pool once instead of per model.
+    // The buffers are host visible when the device supports direct writes.
+    //
+    // Freed ranges are only handed out again once the frame that freed them
+    // comes round again, so frames in flight can keep drawing from them
+    class CGE_Geometry_Pool {
+        public:
+            struct Allocation {
+                uint32_t first_vertex = CGE_Range_Allocator::INVALID;
+                uint32_t vertex_count = 0;
+                uint32_t first_index = CGE_Range_Allocator::INVALID;
+                uint32_t index_count = 0;
+
+                bool valid() const { return first_vertex != CGE_Range_Allocator::INVALID; }
+            };
+
+            static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 1024 * 1024;
+            static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 4 * 1024 * 1024;
+
+            CGE_Geometry_Pool(
+                CGE_Device& device,
+                CGE_Vertex_Format vertex_format = CGE_Vertex_Format::FULL,
+                uint32_t vertex_capacity = DEFAULT_VERTEX_CAPACITY,
+                uint32_t index_capacity = DEFAULT_INDEX_CAPACITY,
+                uint32_t frame_count = CGE_SwapChain::MAX_FRAMES_IN_FLIGHT);
+
+            CGE_Geometry_Pool(const CGE_Geometry_Pool&) = delete;
+            CGE_Geometry_Pool& operator=(const CGE_Geometry_Pool&) = delete;
+
+            // Reserve room for a mesh. Returns an invalid allocation when
+            // either buffer is out of space
+            Allocation allocate(uint32_t vertex_count, uint32_t index_count);
+            // Retire the ranges; they become free at the next begin_frame()
+            // of the current frame index
+            void free(const Allocation& allocation);
+
+            // Release ranges retired the last time frame_index was recorded.
+            // Call once the renderer has waited for that frame
+            void begin_frame(uint32_t frame_index);
+
+            void _bind(VkCommandBuffer command_buffer);
+            void _bind_indices(VkCommandBuffer command_buffer);
+
+            CGE_Vertex_Format get_vertex_format() const { return _vertex_format; }
+            VkDeviceSize get_vertex_stride() const { return _vertex_stride; }
+            CGE_Buffer& get_vertex_buffer() const { return *_vertex_buffer; }
+            CGE_Buffer& get_index_buffer() const { return *_index_buffer; }
+
+            CGE_Range_Allocator::Stats get_vertex_stats() const { return _vertices.get_stats(); }
+            CGE_Range_Allocator::Stats get_index_stats() const { return _indices.get_stats(); }
+
+        private:
+            CGE_Vertex_Format _vertex_format;
+            VkDeviceSize _vertex_stride;
+
+            std::unique_ptr<CGE_Buffer> _vertex_buffer;
+            std::unique_ptr<CGE_Buffer> _index_buffer;
+            CGE_Range_Allocator _vertices;
+            CGE_Range_Allocator _indices;
+
+            // Freed allocations by the frame index they were freed in
+            std::vector<std::vector<Allocation>> _retired;
+            uint32_t _frame_index = 0;
+    };
+
+} // cge
+
+#endif /* CGE_GEOMETRY_POOL */
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef CGE_GROWABLE_BUFFER
+#define CGE_GROWABLE_BUFFER
+
+#include "cge_device.hh"
+#include "cge_buffer.hh"
+#include "cge_swap_chain.hh"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace cge {
+
+    // Array of elements in a CGE_Buffer that grows geometrically instead of
+    // being sized for the worst case. Growing moves the contents to a new
+    // buffer: host visible buffers are copied right away through their
+    // mappings, device local ones by a copy recorded into the frame's command
+    // buffer. The old buffer is kept until the frame that replaced it comes
+    // round again, so frames in flight can keep reading it.
+    //
+    // The VkBuffer changes when the buffer grows; rebind it or rewrite
+    // descriptors whenever reserve() returns true
+    class CGE_Growable_Buffer {
+        public:
+            static constexpr float GROWTH_FACTOR = 1.5f;
+
+            CGE_Growable_Buffer(
+                CGE_Device& device,
+                VkDeviceSize element_size,
+                uint32_t initial_capacity,
+                VkBufferUsageFlags usage,
+                VkMemoryPropertyFlags memory_property_flags,
+                uint32_t frame_count = CGE_SwapChain::MAX_FRAMES_IN_FLIGHT);
+
+            CGE_Growable_Buffer(const CGE_Growable_Buffer&) = delete;
+            CGE_Growable_Buffer& operator=(const CGE_Growable_Buffer&) = delete;
+
+            // Free buffers retired the last time frame_index was recorded.
+            // Call once the renderer has waited for that frame
+            void begin_frame(uint32_t frame_index);
+
+            // Make room for count elements, keeping the first get_size().
+            // Device local contents are copied by commands recorded into
+            // command_buffer outside a render pass, or with a blocking submit
+            // when it is VK_NULL_HANDLE. Returns true if the buffer was replaced
+            bool reserve(VkCommandBuffer command_buffer, uint32_t count);
+
+            // reserve() and set the number of elements in use
+            bool resize(VkCommandBuffer command_buffer, uint32_t count);
+
+            CGE_Buffer& get_buffer() { return *_buffer; }
+            VkBuffer get_vk_buffer() const { return _buffer->get_buffer(); }
+            // nullptr unless the memory is host visible
+            void* get_mapped_memory() const { return _buffer->get_mapped_memory(); }
+
+            VkDeviceSize get_element_size() const { return _element_size; }
+            uint32_t get_size() const { return _size; }
+            uint32_t get_capacity() const { return _capacity; }
+            uint32_t get_grow_count() const { return _grow_count; }
+
+        private:
+            std::unique_ptr<CGE_Buffer> _create_buffer(uint32_t capacity);
+
+            CGE_Device& _device;
+            VkDeviceSize _element_size;
+            VkBufferUsageFlags _usage;
+            VkMemoryPropertyFlags _memory_property_flags;
+
+            std::unique_ptr<CGE_Buffer> _buffer;
+            uint32_t _size = 0;
+            uint32_t _capacity = 0;
+            uint32_t _grow_count = 0;
+
+            // Replaced buffers per frame slot, freed when the slot is reused
+            std::vector<std::vector<std::unique_ptr<CGE_Buffer>>> _retired;
+            uint32_t _frame_index = 0;
+    };
+
+} // cge
+
+#endif /* CGE_GROWABLE_BUFFER */
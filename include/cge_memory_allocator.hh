@@ -0,0 +1,173 @@
+#pragma once
+#ifndef CGE_MEMORY_ALLOCATOR
+#define CGE_MEMORY_ALLOCATOR
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace cge {
+
+    struct CGE_Memory_Block;
+
+    // What an allocation is used for, inferred from the buffer or image usage
+    enum class CGE_Memory_Category : uint32_t {
+        GEOMETRY = 0,   // vertex and index buffers
+        UNIFORM,        // uniform, storage and indirect buffers
+        STAGING,        // transfer sources
+        DEPTH,          // depth attachments
+        TEXTURE,        // sampled images
+        OTHER,
+    };
+
+    static constexpr uint32_t CGE_MEMORY_CATEGORY_COUNT = 6;
+
+    const char* cge_memory_category_name(CGE_Memory_Category category);
+
+    // A range of device memory handed out by CGE_Memory_Allocator
+    struct CGE_Allocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;              // requested size
+        VkDeviceSize allocated_size = 0;    // size actually reserved, at least size
+        void* mapped = nullptr;             // host address of offset if host visible
+        uint32_t memory_type = 0;
+        CGE_Memory_Category category = CGE_Memory_Category::OTHER;
+
+        CGE_Memory_Block* block = nullptr;  // nullptr for dedicated allocations
+        uint32_t order = 0;
+    };
+
+    // Sub-allocates buffers and images from large per memory type blocks with a
+    // buddy allocator, so the number of vkAllocateMemory calls stays small.
+    // Buddy ranges are aligned to their own size, which covers any alignment
+    // up to the range size. Linear (buffer) and optimal tiling (image)
+    // resources never share a block, which keeps them bufferImageGranularity
+    // apart. Host visible blocks stay mapped for their whole lifetime
+    class CGE_Memory_Allocator {
+        public:
+            // Default block size. Heaps smaller than 8 blocks use heap_size / 8
+            static constexpr VkDeviceSize BLOCK_SIZE = 64 * 1024 * 1024;
+            static constexpr VkDeviceSize MIN_ALLOCATION = 256;
+
+            struct Heap_Stats {
+                uint32_t allocation_count = 0;      // live allocations
+                uint32_t device_allocations = 0;    // vkAllocateMemory objects: blocks + dedicated
+                VkDeviceSize allocated_bytes = 0;   // total size of those objects
+                VkDeviceSize used_bytes = 0;        // requested by live allocations
+                VkDeviceSize wasted_bytes = 0;      // buddy rounding of live allocations
+            };
+
+            struct Category_Stats {
+                uint32_t allocation_count = 0;
+                VkDeviceSize bytes = 0;             // requested by live allocations
+                VkDeviceSize peak_bytes = 0;
+            };
+
+            // How static geometry reached device memory
+            struct Upload_Stats {
+                bool direct_write = false;          // uses_direct_write() at startup
+                uint32_t direct_uploads = 0;        // written through a mapping
+                VkDeviceSize direct_bytes = 0;
+                uint32_t staged_uploads = 0;        // copied from staging memory
+                VkDeviceSize staged_bytes = 0;
+            };
+
+            // With device_address every block is allocated with
+            // VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, so buffers created with
+            // VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT may be bound anywhere
+            CGE_Memory_Allocator(VkPhysicalDevice physical_device, VkDevice device, bool device_address = false);
+            ~CGE_Memory_Allocator();
+
+            CGE_Memory_Allocator(const CGE_Memory_Allocator&) = delete;
+            CGE_Memory_Allocator& operator=(const CGE_Memory_Allocator&) = delete;
+
+            // linear is true for buffers and linear tiling images
+            CGE_Allocation allocate(
+                const VkMemoryRequirements& requirements,
+                uint32_t memory_type,
+                bool linear,
+                CGE_Memory_Category category = CGE_Memory_Category::OTHER);
+            void free(const CGE_Allocation& allocation);
+
+            // Memory type in type_bits with every required flag. Among those,
+            // the most preferred flags win, then the fewest flags nobody asked
+            // for (so plain HOST_VISIBLE requests stay out of a small device
+            // local BAR heap), then the largest heap. Throws if none qualifies
+            uint32_t find_memory_type(
+                uint32_t type_bits,
+                VkMemoryPropertyFlags required,
+                VkMemoryPropertyFlags preferred = 0) const;
+            VkMemoryPropertyFlags get_memory_type_flags(uint32_t memory_type) const {
+                return _memory_properties.memoryTypes[memory_type].propertyFlags;
+            }
+
+            // True when host visible, coherent memory lives on the largest
+            // device local heap (ReBAR, integrated and software devices). Static
+            // data is then written in place instead of copied through staging
+            bool uses_direct_write() const { return _direct_write; }
+
+            void record_upload(VkDeviceSize bytes, bool direct);
+
+            // Indexed by memory heap
+            std::vector<Heap_Stats> get_heap_stats() const;
+            Upload_Stats get_upload_stats() const;
+            std::array<Category_Stats, CGE_MEMORY_CATEGORY_COUNT> get_category_stats() const;
+            uint32_t get_heap_count() const { return _memory_properties.memoryHeapCount; }
+            const VkMemoryHeap& get_heap(uint32_t heap) const { return _memory_properties.memoryHeaps[heap]; }
+
+        private:
+            struct Memory_Type {
+                std::vector<std::unique_ptr<CGE_Memory_Block>> blocks;
+                VkDeviceSize block_size = BLOCK_SIZE;
+                bool host_visible = false;
+
+                uint32_t allocation_count = 0;
+                uint32_t dedicated_count = 0;
+                VkDeviceSize dedicated_bytes = 0;
+                VkDeviceSize used_bytes = 0;
+                VkDeviceSize wasted_bytes = 0;
+            };
+
+            VkDeviceMemory _allocate_memory(uint32_t memory_type, VkDeviceSize size, void** mapped);
+            CGE_Memory_Block* _create_block(uint32_t memory_type, bool linear);
+
+            VkDevice _device;
+            VkPhysicalDeviceMemoryProperties _memory_properties;
+            std::vector<Memory_Type> _memory_types;
+            bool _direct_write = false;
+            bool _device_address = false;
+            Upload_Stats _upload_stats;
+            std::array<Category_Stats, CGE_MEMORY_CATEGORY_COUNT> _categories{};
+
+            mutable std::mutex _mutex;
+    };
+
+    // Device memory use at one point in time, from CGE_Device::memorySnapshot
+    struct CGE_Memory_Snapshot {
+        struct Heap {
+            VkDeviceSize size = 0;
+            bool device_local = false;
+            // From VK_EXT_memory_budget when available, otherwise the heap
+            // size and the engine's own allocations
+            VkDeviceSize budget = 0;
+            VkDeviceSize usage = 0;
+            CGE_Memory_Allocator::Heap_Stats engine;
+        };
+
+        bool budget_available = false;
+        std::vector<Heap> heaps;
+        std::array<CGE_Memory_Allocator::Category_Stats, CGE_MEMORY_CATEGORY_COUNT> categories{};
+        CGE_Memory_Allocator::Upload_Stats uploads;
+
+        // Human readable report, one line per heap and category
+        void print(std::ostream& out) const;
+    };
+
+} // cge
+
+#endif /* CGE_MEMORY_ALLOCATOR */
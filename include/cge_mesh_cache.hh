@@ -0,0 +1,100 @@
+#pragma once
+#ifndef CGE_MESH_CACHE
+#define CGE_MESH_CACHE
+
+#include "cge_model.hh"
+#include "cge_meshlet.hh"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace cge {
+
+    // On-disk header of a .cgemesh file. The vertex and index arrays follow
+    // at the recorded offsets, laid out exactly as CGE_Model::Vertex / uint32_t
+    // so they can be copied from the mapping into a staging buffer as-is.
+    // The CGE_Meshlet and CGE_Model::Lod arrays follow the indices
+    struct CGE_Mesh_Cache_Header {
+        char magic[4];          // "CGEM"
+        uint32_t version;
+        uint64_t source_hash;   // hash_bytes() over the source file contents
+        int64_t source_mtime;   // source last write time, in file clock ticks
+        uint64_t source_size;
+        uint32_t vertex_size;   // sizeof(CGE_Model::Vertex) when written
+        uint32_t vertex_count;
+        uint32_t index_count;
+        uint32_t lod_count;
+        uint64_t vertex_offset;
+        uint64_t index_offset;
+        uint32_t meshlet_size;  // sizeof(CGE_Meshlet) when written
+        uint32_t meshlet_count;
+        uint64_t meshlet_offset;
+        uint64_t options_key;   // CGE_Model::Builder::cache_key() of the import
+        uint64_t lod_offset;
+    };
+
+    class CGE_Mesh_Cache {
+        public:
+            // Bump whenever the header or payload layout changes.
+            // Files with any other version are treated as stale and re-imported
+            static constexpr uint32_t VERSION = 4;
+
+            // Read-only memory mapping of a validated .cgemesh file
+            class Mapped_Mesh {
+                public:
+                    Mapped_Mesh(void* data, size_t size);
+                    ~Mapped_Mesh();
+
+                    Mapped_Mesh(const Mapped_Mesh&) = delete;
+                    Mapped_Mesh& operator=(const Mapped_Mesh&) = delete;
+
+                    const CGE_Mesh_Cache_Header& header() const {
+                        return *static_cast<const CGE_Mesh_Cache_Header*>(_data);
+                    }
+                    const CGE_Model::Vertex* vertices() const {
+                        return reinterpret_cast<const CGE_Model::Vertex*>(_bytes() + header().vertex_offset);
+                    }
+                    const uint32_t* indices() const {
+                        return reinterpret_cast<const uint32_t*>(_bytes() + header().index_offset);
+                    }
+                    const CGE_Meshlet* meshlets() const {
+                        return reinterpret_cast<const CGE_Meshlet*>(_bytes() + header().meshlet_offset);
+                    }
+                    uint32_t vertex_count() const { return header().vertex_count; }
+                    uint32_t index_count() const { return header().index_count; }
+                    const CGE_Model::Lod* lods() const {
+                        return reinterpret_cast<const CGE_Model::Lod*>(_bytes() + header().lod_offset);
+                    }
+                    uint32_t meshlet_count() const { return header().meshlet_count; }
+                    uint32_t lod_count() const { return header().lod_count; }
+
+                    CGE_Model::Mesh_View view() const;
+
+                private:
+                    const char* _bytes() const { return static_cast<const char*>(_data); }
+
+                    void* _data;
+                    size_t _size;
+            };
+
+            // models/smooth_vase.obj -> models/smooth_vase.cgemesh
+            static std::string cache_path(const std::string& source_path);
+
+            // Map the cache for source_path if it exists, still matches the source
+            // and was imported with the given CGE_Model::Builder::cache_key().
+            // Returns nullptr on a miss so the caller can fall back to a full import
+            static std::unique_ptr<Mapped_Mesh> load(const std::string& source_path, uint64_t options_key);
+
+            // Write the imported geometry next to the source file
+            // Returns false if the cache could not be written; this is never fatal
+            static bool store(const std::string& source_path, const CGE_Model::Builder& builder);
+
+        private:
+            static bool _hash_file(const std::string& path, uint64_t& hash);
+    };
+
+} // cge
+
+#endif /* CGE_MESH_CACHE */
@@ -0,0 +1,74 @@
+#pragma once
+#ifndef CGE_MESH_OPTIMIZER
+#define CGE_MESH_OPTIMIZER
+
+#include "cge_model.hh"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace cge {
+
+    // Post-transform vertex cache statistics for an index stream, simulated
+    // with a FIFO cache of the given size
+    struct CGE_Vertex_Cache_Stats {
+        uint32_t triangles = 0;
+        uint32_t vertices_transformed = 0;
+        float acmr = 0.f;   // average cache miss ratio: transformed / triangles
+        float atvr = 0.f;   // average transform to vertex ratio: transformed / unique vertices
+    };
+
+    // Index and vertex reordering run on a Builder after deduplication.
+    // None of these passes change the rendered result, only the order
+    // triangles and vertices reach the GPU in
+    class CGE_Mesh_Optimizer {
+        public:
+            // Cache size targeted by Tipsify and used when reporting stats.
+            // 16 entries is a conservative match for current hardware
+            static constexpr uint32_t CACHE_SIZE = 16;
+
+            // Clusters whose local ACMR is within this factor of their parent
+            // cluster are split off so the overdraw sort has finer pieces to move
+            static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+            static CGE_Vertex_Cache_Stats analyze_vertex_cache(
+                const std::vector<uint32_t>& indices,
+                size_t vertex_count,
+                uint32_t cache_size = CACHE_SIZE);
+
+            // Tipsify (Sander et al. 2007) triangle reordering.
+            // If clusters is given it receives the first triangle of every run
+            // that started from a cache flush, which is where the overdraw pass
+            // is free to cut the stream
+            static void optimize_vertex_cache(
+                std::vector<uint32_t>& indices,
+                size_t vertex_count,
+                std::vector<uint32_t>* clusters = nullptr,
+                uint32_t cache_size = CACHE_SIZE);
+
+            // Sort the clusters produced by optimize_vertex_cache so outward
+            // facing ones are drawn first and occlude the rest
+            static void optimize_overdraw(
+                std::vector<uint32_t>& indices,
+                const std::vector<CGE_Model::Vertex>& vertices,
+                const std::vector<uint32_t>& clusters,
+                float threshold = OVERDRAW_THRESHOLD,
+                uint32_t cache_size = CACHE_SIZE);
+
+            // Renumber vertices in order of first use by the index stream
+            static void optimize_vertex_fetch(
+                std::vector<CGE_Model::Vertex>& vertices,
+                std::vector<uint32_t>& indices);
+
+            // Run all three passes on a builder. before/after, when given,
+            // receive the cache statistics of the input and the result
+            static void optimize(
+                CGE_Model::Builder& builder,
+                CGE_Vertex_Cache_Stats* before = nullptr,
+                CGE_Vertex_Cache_Stats* after = nullptr);
+    };
+
+} // cge
+
+#endif /* CGE_MESH_OPTIMIZER */
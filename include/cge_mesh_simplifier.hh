@@ -0,0 +1,40 @@
+#pragma once
+#ifndef CGE_MESH_SIMPLIFIER
+#define CGE_MESH_SIMPLIFIER
+
+#include "cge_model.hh"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace cge {
+
+    // Quadric error metric edge collapse (Garland & Heckbert 1997) that only
+    // collapses vertices onto existing vertices, so the result is a new index
+    // list over the same vertex array and can share the model's vertex buffer.
+    //
+    // Vertices sharing a position with a different vertex (attribute seams)
+    // and vertices on non-manifold edges are locked. Vertices on open borders
+    // may only slide along the border. Flat shaded meshes, where every corner
+    // is a seam, therefore barely simplify
+    class CGE_Mesh_Simplifier {
+        public:
+            // Simplify until at most target_index_count indices remain or the next
+            // collapse would exceed target_error. Errors are distances relative
+            // to the largest side of the mesh bounds; result_error receives the
+            // largest error actually introduced
+            static std::vector<uint32_t> simplify(
+                const std::vector<CGE_Model::Vertex>& vertices,
+                const std::vector<uint32_t>& indices,
+                size_t target_index_count,
+                float target_error,
+                float* result_error = nullptr);
+
+            // Scale that turns a relative simplify() error into object space units
+            static float error_scale(const std::vector<CGE_Model::Vertex>& vertices);
+    };
+
+} // cge
+
+#endif /* CGE_MESH_SIMPLIFIER */
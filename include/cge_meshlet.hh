@@ -0,0 +1,83 @@
+#pragma once
+#ifndef CGE_MESHLET
+#define CGE_MESHLET
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_PATTERN_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cge {
+
+    // A cluster of at most MAX_VERTICES unique vertices and MAX_TRIANGLES
+    // triangles, stored as a contiguous range of the model's index buffer.
+    // Bounds are in object space. Stored as-is in the .cgemesh cache
+    struct CGE_Meshlet {
+        glm::vec3 center{};         // bounding sphere
+        float radius = 0.f;
+        glm::vec3 cone_apex{};      // normal cone, see cge_meshlet_backfacing
+        float cone_cutoff = 1.f;
+        glm::vec3 cone_axis{0.f, 0.f, 1.f};
+        uint32_t first_index = 0;
+        uint32_t triangle_count = 0;
+        uint32_t vertex_count = 0;
+        uint32_t reserved[2] = {};
+    };
+
+    static_assert(sizeof(CGE_Meshlet) == 64, "CGE_Meshlet is part of the cache format");
+
+    class CGE_Meshlet_Builder {
+        public:
+            static constexpr uint32_t MAX_VERTICES = 64;
+            static constexpr uint32_t MAX_TRIANGLES = 124;
+
+            // Split the index stream into meshlets in order, starting a new one
+            // whenever the next triangle would exceed either limit. Indices are
+            // not reordered, so run the mesh optimizer first for tight clusters.
+            // positions points at the first vertex's xyz, vertex_stride is in bytes
+            static void build(
+                const float* positions,
+                size_t vertex_count,
+                size_t vertex_stride,
+                const uint32_t* indices,
+                size_t index_count,
+                std::vector<CGE_Meshlet>& meshlets);
+    };
+
+    // View frustum as six inward facing planes (xyz normal, w distance)
+    struct CGE_Frustum {
+        glm::vec4 planes[6];
+
+        // Extract the planes of a Vulkan clip space matrix (depth 0..1).
+        // Passing projection * view * model gives planes in object space
+        static CGE_Frustum from_matrix(const glm::mat4& clip);
+
+        bool intersects_sphere(const glm::vec3& center, float radius) const;
+    };
+
+    // True if every triangle of the meshlet faces away from camera_position
+    // (same space as the meshlet bounds). Only meaningful when back faces
+    // are not visible, i.e. closed meshes or a pipeline that culls them
+    bool cge_meshlet_backfacing(const CGE_Meshlet& meshlet, const glm::vec3& camera_position);
+
+    // Write indirect draws for the meshlets that survive culling.
+    // Adjacent visible meshlets are merged into one command, so out needs
+    // room for at most meshlet_count commands. Returns the command count.
+    // first_index and vertex_offset place the model in a shared index and
+    // vertex buffer, see CGE_Geometry_Pool
+    uint32_t cge_cull_meshlets(
+        const CGE_Meshlet* meshlets,
+        uint32_t meshlet_count,
+        const CGE_Frustum& frustum,
+        const glm::vec3* camera_position,   // nullptr skips the normal cone test
+        VkDrawIndexedIndirectCommand* out,
+        uint32_t first_index = 0,
+        int32_t vertex_offset = 0);
+
+} // cge
+
+#endif /* CGE_MESHLET */
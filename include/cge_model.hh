@@ -4,6 +4,10 @@
 
 #include "cge_device.hh"
 #include "cge_buffer.hh"
+#include "cge_vertex_format.hh"
+#include "cge_meshlet.hh"
+#include "cge_upload_batcher.hh"
+#include "cge_geometry_pool.hh"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_PATTERN_ZERO_TO_ONE
@@ -34,26 +38,152 @@ namespace cge {
                 }
             };
 
+            // One level of detail: a range of the shared index buffer and the
+            // meshlets covering it. Level 0 is the full mesh
+            struct Lod {
+                uint32_t first_index = 0;
+                uint32_t index_count = 0;
+                uint32_t first_meshlet = 0;
+                uint32_t meshlet_count = 0;
+                float error = 0.f;      // object space deviation from level 0
+                uint32_t reserved[3] = {};
+            };
+
+            struct Lod_Settings {
+                // Target triangle count of each extra level relative to the
+                // full mesh, finest first. Empty disables LOD generation
+                std::vector<float> ratios{0.5f, 0.25f, 0.125f};
+
+                // Largest error a level may introduce, relative to the
+                // largest side of the mesh bounds
+                float max_error = 0.05f;
+
+                // Meshes with fewer triangles only get level 0
+                uint32_t min_triangles = 256;
+            };
+
+            // Borrowed view of imported geometry, from a Builder or a mapped .cgemesh
+            struct Mesh_View {
+                const Vertex* vertices = nullptr;
+                uint32_t vertex_count = 0;
+                const uint32_t* indices = nullptr;
+                uint32_t index_count = 0;
+                const CGE_Meshlet* meshlets = nullptr;
+                uint32_t meshlet_count = 0;
+                const Lod* lods = nullptr;
+                uint32_t lod_count = 0;
+            };
+
             struct Builder {
                 std::vector<Vertex> vertices{};
-                std::vector<uint32_t> indices{};
+                std::vector<uint32_t> indices{};     // every LOD back to back
+                std::vector<CGE_Meshlet> meshlets{}; // every LOD back to back
+                std::vector<Lod> lods{};
+
+                // Write a .cgemesh next to the source after importing it
+                bool write_cache = true;
+
+                // Reorder the deduplicated mesh for the vertex cache, overdraw
+                // and vertex fetch (see CGE_Mesh_Optimizer)
+                bool optimize = false;
+
+                Lod_Settings lod_settings{};
+
+                // Layout the model is uploaded in
+                CGE_Vertex_Format vertex_format = CGE_Vertex_Format::FULL;
 
                 void load_models(const std::string& filepath);
+
+                // Hash of the options that change the imported geometry,
+                // so a .cgemesh written with other options is not reused
+                uint64_t cache_key() const;
+
+                Mesh_View view() const;
+
+                void _generate_lods();
+                void _generate_meshlets();
             };
 
             CGE_Model(CGE_Device &device, const CGE_Model::Builder& builder);
+
+            // The arrays are only read during construction.
+            // With a batcher the buffer copies are only recorded; the model may
+            // be drawn once the batch it went into has completed. Without one
+            // the constructor waits for its own single submit.
+            // With a pool of the same vertex format the geometry is placed in
+            // the pool's shared buffers, falling back to own buffers when full
+            CGE_Model(
+                CGE_Device &device,
+                const Mesh_View& mesh,
+                CGE_Vertex_Format vertex_format = CGE_Vertex_Format::FULL,
+                CGE_Upload_Batcher* batcher = nullptr,
+                CGE_Geometry_Pool* pool = nullptr);
             ~CGE_Model();
             CGE_Model(const CGE_Model&) = delete;
             CGE_Model &operator=(const CGE_Model&) = delete;
 
-            static std::unique_ptr<CGE_Model> create_model_from_file(CGE_Device& device, const std::string &file_path);
+            static std::unique_ptr<CGE_Model> create_model_from_file(
+                CGE_Device& device,
+                const std::string &file_path,
+                bool optimize = true,
+                CGE_Vertex_Format vertex_format = CGE_Vertex_Format::FULL,
+                CGE_Geometry_Pool* pool = nullptr);
+
+            // Binding and attribute descriptions of a vertex format,
+            // for PipelineConfigInfo
+            static std::vector<VkVertexInputBindingDescription> get_binding_description(CGE_Vertex_Format format);
+            static std::vector<VkVertexInputAttributeDescription> get_attribute_description(CGE_Vertex_Format format);
+
+            // Usage of every vertex buffer created for device. Adds
+            // VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT when the device supports
+            // it, so the buffer can also be read by vertex pulling shaders
+            static VkBufferUsageFlags vertex_buffer_usage(CGE_Device& device);
 
             void _bind(VkCommandBuffer command_buffer);
-            void _draw(VkCommandBuffer command_buffer);
+            // Bind only the index buffer, for pipelines that fetch vertices
+            // themselves from get_vertex_address()
+            void _bind_indices(VkCommandBuffer command_buffer);
+            void _draw(VkCommandBuffer command_buffer, uint32_t lod = 0);
+
+            // Draw draw_count VkDrawIndexedIndirectCommand from buffer at offset,
+            // e.g. the visible meshlet ranges written by cge_cull_meshlets
+            void _draw_indirect(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count);
+
+            const std::vector<CGE_Meshlet>& get_meshlets() const { return _meshlets; }
+            uint32_t get_index_count() const { return _index_count; }
+
+            // Pool the model lives in, or nullptr if it owns its buffers.
+            // Models of the same pool only need to be bound once
+            const CGE_Geometry_Pool* get_geometry_pool() const { return _pool; }
+
+            // Added to every vertex index and first index of the model's draws
+            int32_t get_base_vertex() const { return static_cast<int32_t>(_base_vertex); }
+            uint32_t get_first_index() const { return _first_index; }
+
+            // Device address of the vertex buffer the model lives in, or 0
+            // without buffer device address. It is indexed like a bound vertex
+            // buffer: gl_VertexIndex already includes get_base_vertex()
+            VkDeviceAddress get_vertex_address() const;
+            // Vertex size in bytes for the model's format
+            uint32_t get_vertex_stride() const;
+
+            // Always holds at least level 0 when the model is indexed
+            const std::vector<Lod>& get_lods() const { return _lods; }
+
+            // Object space bounding sphere of level 0
+            const glm::vec3& get_bounds_center() const { return _bounds_center; }
+            float get_bounds_radius() const { return _bounds_radius; }
+
+            CGE_Vertex_Format get_vertex_format() const { return _vertex_format; }
+
+            // Maps packed positions back to object space. Fold it into the
+            // model matrix when drawing; it is the identity for FULL
+            const glm::mat4& get_dequantization() const { return _dequantization; }
 
         private:
-            void _create_vertex_buffers(const std::vector<Vertex> &vertices);
-            void _create_index_buffers(const std::vector<uint32_t> &indices);
+            void _create_vertex_buffers(const Vertex* vertices, uint32_t vertex_count, CGE_Upload_Batcher& batcher);
+            void _create_index_buffers(const uint32_t* indices, uint32_t index_count, CGE_Upload_Batcher& batcher);
+            std::vector<CGE_Packed_Vertex> _pack_vertices(const Vertex* vertices, uint32_t vertex_count);
 
             CGE_Device &_device;
 //            VkBuffer _vertex_buffer;
@@ -65,8 +195,24 @@ namespace cge {
 //            VkDeviceMemory _index_buffer_memory;
             std::unique_ptr<CGE_Buffer> _index_buffer;
             uint32_t _index_count;
+            VkIndexType _index_type = VK_INDEX_TYPE_UINT32;
 
             bool _has_index_buffer = false;
+
+            CGE_Geometry_Pool* _pool = nullptr;
+            CGE_Geometry_Pool::Allocation _pool_allocation{};
+            uint32_t _base_vertex = 0;
+            uint32_t _first_index = 0;
+
+            // CPU copy of the cluster bounds, used for culling
+            std::vector<CGE_Meshlet> _meshlets;
+            std::vector<Lod> _lods;
+
+            glm::vec3 _bounds_center{0.f};
+            float _bounds_radius = 0.f;
+
+            CGE_Vertex_Format _vertex_format;
+            glm::mat4 _dequantization{1.f};
     };
 }
 
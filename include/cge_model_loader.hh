@@ -0,0 +1,131 @@
+#pragma once
+#ifndef CGE_MODEL_LOADER
+#define CGE_MODEL_LOADER
+
+#include "cge_device.hh"
+#include "cge_model.hh"
+#include "cge_mesh_cache.hh"
+#include "cge_upload_batcher.hh"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_PATTERN_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cge {
+
+    // Result of CGE_Model_Loader::load_async. The state only moves forward;
+    // bounds are readable from PARSED on and the model once RESIDENT
+    class CGE_Model_Handle {
+        public:
+            enum class State {
+                QUEUED,     // waiting for the worker
+                PARSED,     // imported, waiting for an upload slot
+                UPLOADING,  // copies submitted, fence not signaled yet
+                RESIDENT,   // get_model() can be drawn
+                FAILED,     // see get_error()
+            };
+
+            State get_state() const { return _state.load(std::memory_order_acquire); }
+            bool is_resident() const { return get_state() == State::RESIDENT; }
+            bool has_bounds() const { return get_state() != State::QUEUED && get_state() != State::FAILED; }
+
+            const std::string& get_path() const { return _path; }
+
+            // Object space AABB of the imported mesh
+            const glm::vec3& get_bounds_min() const { return _bounds_min; }
+            const glm::vec3& get_bounds_max() const { return _bounds_max; }
+
+            // Only touched by the main thread, after the upload completed
+            const std::shared_ptr<CGE_Model>& get_model() const { return _model; }
+            const std::string& get_error() const { return _error; }
+
+        private:
+            friend class CGE_Model_Loader;
+
+            std::atomic<State> _state{State::QUEUED};
+            std::string _path;
+            bool _optimize = true;
+            CGE_Vertex_Format _vertex_format = CGE_Vertex_Format::FULL;
+
+            glm::vec3 _bounds_min{-0.5f};
+            glm::vec3 _bounds_max{0.5f};
+
+            std::shared_ptr<CGE_Model> _model;
+            std::string _error;
+    };
+
+    // Imports models on a worker thread and uploads them without waiting on
+    // the GPU. Call update() once per frame on the thread that submits to the
+    // graphics queue; it submits the copies of newly parsed models as one
+    // batch and publishes the ones whose batch has completed
+    class CGE_Model_Loader {
+        public:
+            // Staging memory submitted per update() before the rest is left
+            // for later frames. A single larger model is still submitted
+            static constexpr VkDeviceSize UPLOAD_BUDGET = 16 * 1024 * 1024;
+
+            // Models in the pool's vertex format are placed in the pool
+            CGE_Model_Loader(CGE_Device& device, CGE_Geometry_Pool* pool = nullptr);
+            ~CGE_Model_Loader();
+
+            CGE_Model_Loader(const CGE_Model_Loader&) = delete;
+            CGE_Model_Loader& operator=(const CGE_Model_Loader&) = delete;
+
+            // Queue a model, same options as CGE_Model::create_model_from_file
+            std::shared_ptr<CGE_Model_Handle> load_async(
+                const std::string& file_path,
+                bool optimize = true,
+                CGE_Vertex_Format vertex_format = CGE_Vertex_Format::FULL);
+
+            void update();
+
+            // True while anything is queued, parsing or uploading
+            bool is_busy() const;
+
+        private:
+            // A model between parsing and residency. The geometry lives either in
+            // the builder or in the mapped cache until the copies are recorded
+            struct Pending_Upload {
+                std::shared_ptr<CGE_Model_Handle> handle;
+                CGE_Model::Builder builder;
+                std::unique_ptr<CGE_Mesh_Cache::Mapped_Mesh> cached;
+                CGE_Model::Mesh_View mesh{};
+
+                std::unique_ptr<CGE_Model> model;
+                uint64_t batch = 0;
+            };
+
+            void _worker_main();
+            void _record_upload(Pending_Upload& upload);
+            void _finish_upload(Pending_Upload& upload);
+
+            CGE_Device& _device;
+            CGE_Geometry_Pool* _pool;
+
+            mutable std::mutex _mutex;
+            std::condition_variable _work_ready;
+            std::deque<std::shared_ptr<CGE_Model_Handle>> _queue;
+            std::deque<std::unique_ptr<Pending_Upload>> _parsed;
+            bool _stopping = false;
+            bool _parsing = false;
+
+            // Main thread only
+            CGE_Upload_Batcher _batcher;
+            std::vector<std::unique_ptr<Pending_Upload>> _in_flight;
+
+            std::thread _worker;
+    };
+
+} // cge
+
+#endif /* CGE_MODEL_LOADER */
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef CGE_OBJ_LOADER
+#define CGE_OBJ_LOADER
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cge {
+
+    // One triangle corner, as zero-based indices into the CGE_Obj_Data arrays.
+    // -1 marks an attribute the face did not reference
+    struct CGE_Obj_Corner {
+        int32_t position;
+        int32_t texcoord;
+        int32_t normal;
+    };
+
+    // Flattened contents of a Wavefront .obj file.
+    // Polygons are fan-triangulated, so corners.size() is always a multiple of 3
+    struct CGE_Obj_Data {
+        std::vector<float> positions;   // xyz per vertex
+        std::vector<float> colors;      // rgb per vertex, white when the file has none
+        std::vector<float> normals;     // xyz per normal
+        std::vector<float> texcoords;   // uv per texcoord
+        std::vector<CGE_Obj_Corner> corners;
+    };
+
+    // Memory-mapped, multithreaded .obj reader.
+    // The file is split into line-aligned chunks that are parsed in parallel,
+    // then the per-chunk arrays are concatenated and relative face indices are
+    // resolved against the global element counts.
+    // Only geometry is read: v, vn, vt and f. Everything else is skipped
+    class CGE_Obj_Loader {
+        public:
+            // Throws std::runtime_error if the file cannot be read or references
+            // an element that does not exist.
+            // thread_count == 0 uses std::thread::hardware_concurrency()
+            static void load(const std::string& filepath, CGE_Obj_Data& out, unsigned thread_count = 0);
+
+            // Files smaller than this are parsed on the calling thread
+            static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+    };
+
+} // cge
+
+#endif /* CGE_OBJ_LOADER */
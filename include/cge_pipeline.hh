@@ -16,6 +16,8 @@ namespace cge {
         PipelineConfigInfo &operator=(const PipelineConfigInfo&) = delete;
         // PipelineConfigInfo() = default;
 
+        std::vector<VkVertexInputBindingDescription> _binding_descriptions{};
+        std::vector<VkVertexInputAttributeDescription> _attribute_descriptions{};
         VkPipelineViewportStateCreateInfo _viewport_info;
         VkPipelineInputAssemblyStateCreateInfo _input_assembly_info;
 //        VkViewport _viewport;
@@ -12,6 +12,7 @@
 #include "cge_device.hh"
 #include "cge_window.hh"
 #include "cge_swap_chain.hh"
+#include "cge_frame_arena.hh"
 
 namespace cge {
 
@@ -37,6 +38,9 @@ namespace cge {
             }
             VkRenderPass get_swap_chain_render_pass() const { return this->_swap_chain->getRenderPass(); }
 
+            // Scratch memory for the frame being recorded, reset by begin_frame()
+            CGE_Frame_Arena& get_frame_arena() { return this->_frame_arena; }
+
             int get_current_frame_index() const { 
                 assert (this->_is_frame_started && "Cannot get frame index when frame is not in progress");
                 return this->_current_frame_index; 
@@ -54,6 +58,7 @@ namespace cge {
             uint32_t _current_image_index;
             int _current_frame_index{0};
             bool _is_frame_started = false;
+            CGE_Frame_Arena _frame_arena {CGE_Frame_Arena::DEFAULT_CAPACITY, CGE_SwapChain::MAX_FRAMES_IN_FLIGHT, true};
     };
 }
 
@@ -0,0 +1,133 @@
+#pragma once
+#ifndef CGE_SCENE_GRAPH
+#define CGE_SCENE_GRAPH
+
+#include "cge_ecs.hh"
+#include "cge_game_object.hh"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cge {
+
+    // World space matrices of an entity in a CGE_Scene_Graph: its parent's
+    // world matrices times its own TransformComponent. Written by
+    // CGE_Scene_Graph::update and drawn instead of the local matrices
+    struct WorldTransformComponent {
+        glm::mat4 matrix{1.f};
+        glm::mat3 normal_matrix{1.f};
+    };
+
+    // Parent links between entities. Entities that are never attached keep
+    // using their own transform, so a world without links stays a flat list
+    // of objects.
+    //
+    // The hierarchy is stored in depth-first order: parents come before
+    // their children and every subtree is contiguous, so world matrices are
+    // computed in one pass from front to back. A node is recomputed only
+    // when its own transform or one of its ancestors changed. Root subtrees
+    // are independent and are split between threads when there are enough
+    // nodes. The threads are started once and reused every update
+    class CGE_Scene_Graph {
+        public:
+            // thread_count == 0 uses std::thread::hardware_concurrency().
+            // Worker threads start the first time the graph is large enough
+            // to split
+            explicit CGE_Scene_Graph(unsigned thread_count = 0);
+            ~CGE_Scene_Graph();
+
+            CGE_Scene_Graph(const CGE_Scene_Graph&) = delete;
+            CGE_Scene_Graph& operator=(const CGE_Scene_Graph&) = delete;
+
+            // Attach child under parent, or make it a root when parent is
+            // invalid. Both join the graph and get a WorldTransformComponent.
+            // Throws if parent is child or one of its descendants
+            void set_parent(CGE_World& world, CGE_Entity child, CGE_Entity parent);
+
+            // Take the entity out of the graph and remove its
+            // WorldTransformComponent. Its children become roots
+            void remove(CGE_World& world, CGE_Entity entity);
+
+            bool contains(CGE_Entity entity) const {
+                return entity.index < _links.size() && _links[entity.index].entity == entity;
+            }
+
+            // Invalid for roots and for entities outside the graph
+            CGE_Entity get_parent(CGE_Entity entity) const {
+                return contains(entity) ? _links[entity.index].parent : CGE_Entity{};
+            }
+
+            uint32_t size() const { return _member_count; }
+            uint32_t get_root_count() const {
+                return _root_starts.empty() ? 0 : static_cast<uint32_t>(_root_starts.size() - 1);
+            }
+
+            // Recompute the world matrices of every changed subtree. Destroyed
+            // entities leave the graph and their children become roots.
+            // Returns the number of nodes recomputed. Does not allocate unless
+            // the graph or the world changed structure
+            uint32_t update(CGE_World& world);
+
+        private:
+            static constexpr uint32_t NO_PARENT = 0xFFFFFFFFu;
+            // Fewer nodes than this per thread are not worth starting a thread for
+            static constexpr uint32_t MIN_NODES_PER_THREAD = 8192;
+
+            // Indexed by CGE_Entity::index; entity is invalid when the index
+            // is not in the graph
+            struct Link {
+                CGE_Entity entity{};
+                CGE_Entity parent{};
+            };
+
+            // In depth-first order
+            struct Node {
+                CGE_Entity entity{};
+                uint32_t parent = NO_PARENT;    // position of the parent
+                uint32_t version = 0;           // transform version last composed
+            };
+
+            void _join(CGE_World& world, CGE_Entity entity);
+            void _rebuild();
+            void _refresh_components(CGE_World& world);
+            void _split_ranges();
+            uint32_t _update_range(uint32_t begin, uint32_t end);
+            void _worker_main(uint32_t range, uint64_t dispatch);
+
+            std::vector<Link> _links;
+            uint32_t _member_count = 0;
+
+            std::vector<Node> _nodes;
+            std::vector<uint32_t> _root_starts;     // position of every root, then _nodes.size()
+            std::vector<uint8_t> _changed;          // by position, set while updating
+
+            // Components by position, valid while the world's structure
+            // version is _components_version
+            std::vector<TransformComponent*> _locals;
+            std::vector<WorldTransformComponent*> _outputs;
+            uint64_t _components_version = ~uint64_t{0};
+
+            bool _order_dirty = false;      // links changed since _nodes was built
+            bool _recompute_all = false;
+
+            // Range r covers positions _range_bounds[r] to _range_bounds[r + 1].
+            // Range 0 runs on the calling thread, range r on _workers[r - 1]
+            unsigned _thread_count;
+            std::vector<uint32_t> _range_bounds;
+            std::vector<uint32_t> _range_recomputed;
+            std::vector<std::thread> _workers;
+
+            std::mutex _mutex;
+            std::condition_variable _work_ready;
+            std::condition_variable _work_done;
+            uint64_t _dispatch = 0;         // bumped to start every update
+            uint32_t _busy_workers = 0;
+            bool _stopping = false;
+    };
+
+} // cge
+
+#endif /* CGE_SCENE_GRAPH */
@@ -0,0 +1,132 @@
+#pragma once
+#ifndef CGE_SLOT_MAP
+#define CGE_SLOT_MAP
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace cge {
+
+    // Values addressed by generational handles, stored densely. A handle is
+    // a slot index and the generation the slot had when the value was
+    // inserted; erasing bumps the generation, so stale handles never reach
+    // a value inserted later into the same slot.
+    //
+    // Insert, erase and lookup are O(1). Values are packed in one array,
+    // so iterating touches no holes. Erasing moves the last value into the
+    // hole, so pointers to values only last until the next insert or erase.
+    // Handles stay valid until their own value is erased. Freed slots form
+    // a list inside the slot array, and after reserve() nothing allocates
+    // as long as size() stays within the reserved capacity
+    template<typename T>
+    class CGE_Slot_Map {
+        public:
+            struct Handle {
+                static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+                uint32_t index = INVALID;
+                uint32_t generation = 0;
+
+                bool valid() const { return index != INVALID; }
+                bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+                bool operator!=(const Handle& other) const { return !(*this == other); }
+            };
+
+            void reserve(uint32_t capacity) {
+                _slots.reserve(capacity);
+                _values.reserve(capacity);
+                _value_slots.reserve(capacity);
+            }
+
+            template<typename... Args>
+            Handle emplace(Args&&... args) {
+                _values.emplace_back(std::forward<Args>(args)...);
+
+                uint32_t index = _free_head;
+                if (index != Handle::INVALID) {
+                    _free_head = _slots[index].target;
+                } else {
+                    index = static_cast<uint32_t>(_slots.size());
+                    _slots.push_back(Slot{});
+                }
+
+                Slot& slot = _slots[index];
+                slot.target = static_cast<uint32_t>(_values.size() - 1);
+                _value_slots.push_back(index);
+                return Handle{index, slot.generation};
+            }
+
+            Handle insert(T value) { return emplace(std::move(value)); }
+
+            // False if the handle was already stale
+            bool erase(Handle handle) {
+                if (!contains(handle))
+                    return false;
+
+                Slot& slot = _slots[handle.index];
+                uint32_t hole = slot.target;
+                uint32_t last = static_cast<uint32_t>(_values.size() - 1);
+                if (hole != last) {
+                    _values[hole] = std::move(_values[last]);
+                    _value_slots[hole] = _value_slots[last];
+                    _slots[_value_slots[hole]].target = hole;
+                }
+                _values.pop_back();
+                _value_slots.pop_back();
+
+                slot.generation++;
+                slot.target = _free_head;
+                _free_head = handle.index;
+                return true;
+            }
+
+            bool contains(Handle handle) const {
+                // Free slots are one generation past every handle given out for them
+                return handle.index < _slots.size() && _slots[handle.index].generation == handle.generation;
+            }
+
+            // nullptr for stale handles
+            T* get(Handle handle) { return contains(handle) ? &_values[_slots[handle.index].target] : nullptr; }
+            const T* get(Handle handle) const { return contains(handle) ? &_values[_slots[handle.index].target] : nullptr; }
+
+            void clear() {
+                while (!_values.empty()) {
+                    erase(get_handle(static_cast<uint32_t>(_values.size() - 1)));
+                }
+            }
+
+            uint32_t size() const { return static_cast<uint32_t>(_values.size()); }
+            bool empty() const { return _values.empty(); }
+
+            // Dense access: position i holds the value of get_handle(i)
+            T* data() { return _values.data(); }
+            const T* data() const { return _values.data(); }
+            Handle get_handle(uint32_t position) const {
+                assert(position < _values.size() && "Position out of range");
+                uint32_t index = _value_slots[position];
+                return Handle{index, _slots[index].generation};
+            }
+
+            typename std::vector<T>::iterator begin() { return _values.begin(); }
+            typename std::vector<T>::iterator end() { return _values.end(); }
+            typename std::vector<T>::const_iterator begin() const { return _values.begin(); }
+            typename std::vector<T>::const_iterator end() const { return _values.end(); }
+
+        private:
+            struct Slot {
+                uint32_t generation = 0;
+                // Position in _values while occupied, next free slot otherwise
+                uint32_t target = Handle::INVALID;
+            };
+
+            std::vector<Slot> _slots;
+            std::vector<T> _values;
+            std::vector<uint32_t> _value_slots;     // slot of every value, by position
+            uint32_t _free_head = Handle::INVALID;
+    };
+
+} // cge
+
+#endif /* CGE_SLOT_MAP */
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef CGE_STAGING_RING
+#define CGE_STAGING_RING
+
+#include "cge_memory_allocator.hh"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace cge {
+
+    class CGE_Device;
+
+    // Long lived, persistently mapped TRANSFER_SRC buffer that staging data
+    // is written into front to back. Each region stays reserved until its
+    // owner releases it, normally once the submit that copies from it has
+    // signalled its fence. Space is only reclaimed from the oldest region
+    // forward, so one slow submit holds back everything allocated after it.
+    //
+    // Copies out of the ring must be recorded on the device's transfer queue
+    class CGE_Staging_Ring {
+        public:
+            struct Region {
+                VkBuffer buffer = VK_NULL_HANDLE;
+                VkDeviceSize offset = 0;
+                VkDeviceSize size = 0;
+                void* data = nullptr;
+                uint64_t id = 0;            // pass to release()
+
+                bool valid() const { return data != nullptr; }
+            };
+
+            CGE_Staging_Ring(CGE_Device& device, VkDeviceSize capacity);
+            ~CGE_Staging_Ring();
+
+            CGE_Staging_Ring(const CGE_Staging_Ring&) = delete;
+            CGE_Staging_Ring& operator=(const CGE_Staging_Ring&) = delete;
+
+            // Reserve size bytes at alignment, a power of two. Returns an invalid
+            // region when there is not enough unreleased space; callers then use
+            // a temporary buffer instead
+            Region allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+            // The GPU is done reading the region
+            void release(uint64_t id);
+
+            VkDeviceSize get_capacity() const { return _capacity; }
+            // Bytes between the oldest unreleased region and the write head,
+            // including padding skipped when wrapping
+            VkDeviceSize get_in_use() const;
+
+        private:
+            struct Entry {
+                uint64_t end;               // ring position after the region
+                bool released;
+            };
+
+            CGE_Device& _device;
+            VkBuffer _buffer = VK_NULL_HANDLE;
+            CGE_Allocation _memory;
+            VkDeviceSize _capacity;
+
+            // Positions grow without wrapping; the offset into the buffer is
+            // position % capacity
+            uint64_t _head = 0;
+            uint64_t _tail = 0;
+            std::deque<Entry> _entries;     // unreclaimed regions, oldest first
+            uint64_t _first_id = 0;         // id of _entries.front()
+
+            mutable std::mutex _mutex;
+    };
+
+} // cge
+
+#endif /* CGE_STAGING_RING */
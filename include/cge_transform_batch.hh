@@ -0,0 +1,51 @@
+#pragma once
+#ifndef CGE_TRANSFORM_BATCH
+#define CGE_TRANSFORM_BATCH
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_PATTERN_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+namespace cge {
+
+    // Structure of arrays view of a batch of transforms, one array per
+    // component: translation[0] holds every x translation and so on
+    struct CGE_Transform_SoA {
+        const float* translation[3] = {};
+        const float* rotation[3] = {};
+        const float* scale[3] = {};
+    };
+
+    // Instruction sets the batch kernel can use, in increasing width
+    enum class CGE_Simd_Level : uint32_t {
+        SCALAR = 0,     // TransformComponent::compose one at a time
+        SSE2,           // 4 transforms at a time
+        AVX2,           // 8 transforms at a time, with FMA
+    };
+
+    const char* cge_simd_level_name(CGE_Simd_Level level);
+
+    // Widest level this build and CPU support, detected once
+    CGE_Simd_Level cge_supported_simd_level();
+
+    // Level cge_compose_transforms uses. Defaults to the supported level;
+    // setting a higher one is clamped to it. Lower levels are for comparing
+    // paths in benchmarks
+    CGE_Simd_Level cge_get_transform_simd_level();
+    void cge_set_transform_simd_level(CGE_Simd_Level level);
+
+    // Model and normal matrices of count transforms, matching
+    // TransformComponent::compose within float rounding. Sines and cosines
+    // use a polynomial accurate to about 1e-7 for angles within a few
+    // thousand radians
+    void cge_compose_transforms(
+        const CGE_Transform_SoA& transforms,
+        uint32_t count,
+        glm::mat4* matrices,
+        glm::mat3* normal_matrices);
+
+} // cge
+
+#endif /* CGE_TRANSFORM_BATCH */
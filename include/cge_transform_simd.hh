@@ -0,0 +1,259 @@
+#pragma once
+#ifndef CGE_TRANSFORM_SIMD
+#define CGE_TRANSFORM_SIMD
+
+// Vector kernel behind cge_compose_transforms, shared by the SSE2 and the
+// AVX2 translation unit. Each unit is compiled with different target flags,
+// so everything here except the entry points has internal linkage: the
+// linker must never merge an AVX encoded helper into the SSE2 path
+
+#include "cge_transform_batch.hh"
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CGE_TRANSFORM_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace cge {
+
+    // Entry points of the vector paths. They process whole groups of 4 or 8
+    // transforms and return how many were done; the caller finishes the rest
+    uint32_t _compose_transforms_sse2(
+        const CGE_Transform_SoA& transforms, uint32_t count, glm::mat4* matrices, glm::mat3* normal_matrices);
+    uint32_t _compose_transforms_avx2(
+        const CGE_Transform_SoA& transforms, uint32_t count, glm::mat4* matrices, glm::mat3* normal_matrices);
+
+#ifdef CGE_TRANSFORM_SIMD_X86
+namespace {
+
+    static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "glm::mat4 must be tightly packed");
+    static_assert(sizeof(glm::mat3) == 9 * sizeof(float), "glm::mat3 must be tightly packed");
+
+    // Transpose 4 lanes of per-element vectors into 4 column major mat4s.
+    // elements[c * 4 + r] holds element (column c, row r) of every transform
+    inline void store_mat4_x4(glm::mat4* out, const __m128* elements) {
+        float* base = reinterpret_cast<float*>(out);
+        for (int column = 0; column < 4; column++) {
+            __m128 r0 = elements[column * 4 + 0];
+            __m128 r1 = elements[column * 4 + 1];
+            __m128 r2 = elements[column * 4 + 2];
+            __m128 r3 = elements[column * 4 + 3];
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(base + 0 * 16 + column * 4, r0);
+            _mm_storeu_ps(base + 1 * 16 + column * 4, r1);
+            _mm_storeu_ps(base + 2 * 16 + column * 4, r2);
+            _mm_storeu_ps(base + 3 * 16 + column * 4, r3);
+        }
+    }
+
+    // Same for mat3, whose 3 float columns are written without touching
+    // the float after the last matrix
+    inline void store_mat3_x4(glm::mat3* out, const __m128* elements) {
+        float* base = reinterpret_cast<float*>(out);
+        for (int column = 0; column < 3; column++) {
+            __m128 r0 = elements[column * 3 + 0];
+            __m128 r1 = elements[column * 3 + 1];
+            __m128 r2 = elements[column * 3 + 2];
+            __m128 r3 = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            __m128 lanes[4] = {r0, r1, r2, r3};
+            for (int k = 0; k < 4; k++) {
+                float* destination = base + k * 9 + column * 3;
+                _mm_storel_pi(reinterpret_cast<__m64*>(destination), lanes[k]);
+                _mm_store_ss(destination + 2, _mm_movehl_ps(lanes[k], lanes[k]));
+            }
+        }
+    }
+
+    struct Simd_SSE2 {
+        using V = __m128;
+        using I = __m128i;
+        static constexpr uint32_t WIDTH = 4;
+
+        static V load(const float* p) { return _mm_loadu_ps(p); }
+        static V set1(float value) { return _mm_set1_ps(value); }
+        static V zero() { return _mm_setzero_ps(); }
+        static V add(V a, V b) { return _mm_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm_div_ps(a, b); }
+        static V madd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        static V bit_and(V a, V b) { return _mm_and_ps(a, b); }
+        static V bit_andnot(V a, V b) { return _mm_andnot_ps(a, b); }
+        static V bit_xor(V a, V b) { return _mm_xor_ps(a, b); }
+
+        static I truncate(V a) { return _mm_cvttps_epi32(a); }
+        static V to_float(I a) { return _mm_cvtepi32_ps(a); }
+        static V as_float(I a) { return _mm_castsi128_ps(a); }
+        static I iset1(int value) { return _mm_set1_epi32(value); }
+        static I iadd(I a, I b) { return _mm_add_epi32(a, b); }
+        static I isub(I a, I b) { return _mm_sub_epi32(a, b); }
+        static I iand(I a, I b) { return _mm_and_si128(a, b); }
+        static I iandnot(I a, I b) { return _mm_andnot_si128(a, b); }
+        static I ishift_to_sign(I a) { return _mm_slli_epi32(a, 29); }
+        static I iequal_zero(I a) { return _mm_cmpeq_epi32(a, _mm_setzero_si128()); }
+
+        static void store_mat4(glm::mat4* out, const V* elements) { store_mat4_x4(out, elements); }
+        static void store_mat3(glm::mat3* out, const V* elements) { store_mat3_x4(out, elements); }
+    };
+
+#if defined(__AVX2__) && defined(__FMA__)
+    struct Simd_AVX2 {
+        using V = __m256;
+        using I = __m256i;
+        static constexpr uint32_t WIDTH = 8;
+
+        static V load(const float* p) { return _mm256_loadu_ps(p); }
+        static V set1(float value) { return _mm256_set1_ps(value); }
+        static V zero() { return _mm256_setzero_ps(); }
+        static V add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm256_div_ps(a, b); }
+        static V madd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+        static V bit_and(V a, V b) { return _mm256_and_ps(a, b); }
+        static V bit_andnot(V a, V b) { return _mm256_andnot_ps(a, b); }
+        static V bit_xor(V a, V b) { return _mm256_xor_ps(a, b); }
+
+        static I truncate(V a) { return _mm256_cvttps_epi32(a); }
+        static V to_float(I a) { return _mm256_cvtepi32_ps(a); }
+        static V as_float(I a) { return _mm256_castsi256_ps(a); }
+        static I iset1(int value) { return _mm256_set1_epi32(value); }
+        static I iadd(I a, I b) { return _mm256_add_epi32(a, b); }
+        static I isub(I a, I b) { return _mm256_sub_epi32(a, b); }
+        static I iand(I a, I b) { return _mm256_and_si256(a, b); }
+        static I iandnot(I a, I b) { return _mm256_andnot_si256(a, b); }
+        static I ishift_to_sign(I a) { return _mm256_slli_epi32(a, 29); }
+        static I iequal_zero(I a) { return _mm256_cmpeq_epi32(a, _mm256_setzero_si256()); }
+
+        // Lanes 0-3 and 4-7 are stored as two groups of 4
+        template<int N, typename Matrix, typename Store>
+        static void store_halves(Matrix* out, const V* elements, Store store) {
+            __m128 low[N];
+            __m128 high[N];
+            for (int i = 0; i < N; i++) {
+                low[i] = _mm256_castps256_ps128(elements[i]);
+                high[i] = _mm256_extractf128_ps(elements[i], 1);
+            }
+            store(out, low);
+            store(out + 4, high);
+        }
+        static void store_mat4(glm::mat4* out, const V* elements) { store_halves<16>(out, elements, store_mat4_x4); }
+        static void store_mat3(glm::mat3* out, const V* elements) { store_halves<9>(out, elements, store_mat3_x4); }
+    };
+#endif
+
+    // Sine and cosine of every lane with one range reduction, after the
+    // single precision Cephes routines: reduce to [-pi/4, pi/4] around the
+    // nearest multiple of pi/2 and pick the sine or cosine polynomial by
+    // octant
+    template<typename S>
+    inline void sincos(typename S::V x, typename S::V& sine, typename S::V& cosine) {
+        using V = typename S::V;
+        using I = typename S::I;
+
+        const V sign_mask = S::as_float(S::iset1(static_cast<int>(0x80000000u)));
+        V sign_sin = S::bit_and(x, sign_mask);
+        x = S::bit_andnot(sign_mask, x);
+
+        // Octant, rounded up to even so the remainder is centred on zero
+        I octant = S::truncate(S::mul(x, S::set1(1.27323954473516f)));
+        octant = S::iand(S::iadd(octant, S::iset1(1)), S::iset1(~1));
+        V y = S::to_float(octant);
+
+        V swap_sign_sin = S::as_float(S::ishift_to_sign(S::iand(octant, S::iset1(4))));
+        V use_sine_poly = S::as_float(S::iequal_zero(S::iand(octant, S::iset1(2))));
+        V sign_cos = S::as_float(S::ishift_to_sign(S::iandnot(S::isub(octant, S::iset1(2)), S::iset1(4))));
+        sign_sin = S::bit_xor(sign_sin, swap_sign_sin);
+
+        // x - y * pi / 4 in three steps to keep the precision of pi
+        x = S::madd(y, S::set1(-0.78515625f), x);
+        x = S::madd(y, S::set1(-2.4187564849853515625e-4f), x);
+        x = S::madd(y, S::set1(-3.77489497744594108e-8f), x);
+        V z = S::mul(x, x);
+
+        V cos_poly = S::set1(2.443315711809948e-5f);
+        cos_poly = S::madd(cos_poly, z, S::set1(-1.388731625493765e-3f));
+        cos_poly = S::madd(cos_poly, z, S::set1(4.166664568298827e-2f));
+        cos_poly = S::mul(S::mul(cos_poly, z), z);
+        cos_poly = S::add(S::madd(z, S::set1(-0.5f), cos_poly), S::set1(1.f));
+
+        V sin_poly = S::set1(-1.9515295891e-4f);
+        sin_poly = S::madd(sin_poly, z, S::set1(8.3321608736e-3f));
+        sin_poly = S::madd(sin_poly, z, S::set1(-1.6666654611e-1f));
+        sin_poly = S::madd(S::mul(sin_poly, z), x, x);
+
+        V sin_part = S::bit_and(use_sine_poly, sin_poly);
+        V cos_part = S::bit_andnot(use_sine_poly, cos_poly);
+        sine = S::bit_xor(S::add(sin_part, cos_part), sign_sin);
+        cosine = S::bit_xor(S::add(S::sub(sin_poly, sin_part), S::sub(cos_poly, cos_part)), sign_cos);
+    }
+
+    // Same math as TransformComponent::compose, S::WIDTH transforms at a time
+    template<typename S>
+    inline uint32_t compose_transforms(
+        const CGE_Transform_SoA& transforms,
+        uint32_t count,
+        glm::mat4* matrices,
+        glm::mat3* normal_matrices
+    ) {
+        using V = typename S::V;
+        const V one = S::set1(1.f);
+
+        uint32_t i = 0;
+        for (; i + S::WIDTH <= count; i += S::WIDTH) {
+            V s3, c3, s2, c2, s1, c1;
+            sincos<S>(S::load(transforms.rotation[2] + i), s3, c3);
+            sincos<S>(S::load(transforms.rotation[0] + i), s2, c2);
+            sincos<S>(S::load(transforms.rotation[1] + i), s1, c1);
+
+            // Rotation without scale, by column
+            V s1s2 = S::mul(s1, s2);
+            V c1s2 = S::mul(c1, s2);
+            V rotation[9] = {
+                S::madd(s1s2, s3, S::mul(c1, c3)),
+                S::mul(c2, s3),
+                S::sub(S::mul(c1s2, s3), S::mul(c3, s1)),
+                S::sub(S::mul(c3, s1s2), S::mul(c1, s3)),
+                S::mul(c2, c3),
+                S::madd(c1s2, c3, S::mul(s1, s3)),
+                S::mul(c2, s1),
+                S::sub(S::zero(), s2),
+                S::mul(c1, c2),
+            };
+
+            V scale[3];
+            V inverse_scale[3];
+            for (int axis = 0; axis < 3; axis++) {
+                scale[axis] = S::load(transforms.scale[axis] + i);
+                inverse_scale[axis] = S::div(one, scale[axis]);
+            }
+
+            V matrix[16];
+            V normal_matrix[9];
+            for (int column = 0; column < 3; column++) {
+                for (int row = 0; row < 3; row++) {
+                    matrix[column * 4 + row] = S::mul(scale[column], rotation[column * 3 + row]);
+                    normal_matrix[column * 3 + row] = S::mul(inverse_scale[column], rotation[column * 3 + row]);
+                }
+                matrix[column * 4 + 3] = S::zero();
+            }
+            matrix[12] = S::load(transforms.translation[0] + i);
+            matrix[13] = S::load(transforms.translation[1] + i);
+            matrix[14] = S::load(transforms.translation[2] + i);
+            matrix[15] = one;
+
+            S::store_mat4(matrices + i, matrix);
+            S::store_mat3(normal_matrices + i, normal_matrix);
+        }
+        return i;
+    }
+
+} // anonymous
+#endif /* CGE_TRANSFORM_SIMD_X86 */
+
+} // cge
+
+#endif /* CGE_TRANSFORM_SIMD */
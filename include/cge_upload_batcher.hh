@@ -0,0 +1,108 @@
+#pragma once
+#ifndef CGE_UPLOAD_BATCHER
+#define CGE_UPLOAD_BATCHER
+
+#include "cge_device.hh"
+#include "cge_buffer.hh"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace cge {
+
+    // Records many staging copies into one command buffer and submits them
+    // together, instead of one blocking submit per copy. Staging memory comes
+    // from the device's staging ring and is released once the batch completed;
+    // copies that do not fit in the ring fall back to temporary chunks.
+    //
+    // Copies run on the device's transfer queue. When that is a separate
+    // family, each batch releases its buffers to the graphics family and a
+    // small acquire submit on the graphics queue waits for the copy through
+    // a semaphore. The acquire is only submitted after the copy has finished,
+    // so the graphics queue never idles on a transfer in progress.
+    //
+    // Not thread safe; use it from the thread that submits to the graphics queue
+    class CGE_Upload_Batcher {
+        public:
+            // Size of the temporary staging chunks used when the ring is full.
+            // Larger copies get a chunk of their own
+            static constexpr VkDeviceSize STAGING_CHUNK_SIZE = 8 * 1024 * 1024;
+
+            CGE_Upload_Batcher(CGE_Device& device);
+            // Waits for every submitted batch
+            ~CGE_Upload_Batcher();
+
+            CGE_Upload_Batcher(const CGE_Upload_Batcher&) = delete;
+            CGE_Upload_Batcher& operator=(const CGE_Upload_Batcher&) = delete;
+
+            // Stage size bytes of data and record a copy into dst at dst_offset.
+            // data may be reused on return. The copy runs with the next submit(),
+            // so dst must outlive the batch. dst must use exclusive sharing
+            void upload(VkBuffer dst, const void* data, VkDeviceSize size, VkDeviceSize dst_offset = 0);
+
+            // Submit everything recorded since the last submit. Returns the batch
+            // id to pass to is_complete, or the previous id if nothing was recorded
+            uint64_t submit();
+
+            // Hand finished copies to the graphics queue and free the staging
+            // memory of completed batches. Call regularly, e.g. once per frame
+            void collect();
+
+            // True once batch and every batch before it can be used by the
+            // graphics queue
+            bool is_complete(uint64_t batch);
+
+            // Submit and wait for everything
+            void flush();
+
+            // Bytes recorded since the last submit
+            VkDeviceSize get_recorded_bytes() const { return _recorded_bytes; }
+
+        private:
+            struct Batch {
+                uint64_t id = 0;
+                VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+                VkFence fence = VK_NULL_HANDLE;
+                std::vector<uint64_t> ring_regions;
+                std::vector<std::unique_ptr<CGE_Buffer>> staging;
+
+                // Only used with a separate transfer family
+                VkCommandBuffer acquire_command_buffer = VK_NULL_HANDLE;
+                VkFence acquire_fence = VK_NULL_HANDLE;
+                VkSemaphore transferred = VK_NULL_HANDLE;
+                std::vector<VkBufferMemoryBarrier> ownership;
+                bool acquire_submitted = false;
+            };
+
+            void _begin_batch();
+            void _submit_acquire(Batch& batch);
+            VkFence _completion_fence(const Batch& batch) const;
+            void _release_batch(std::unique_ptr<Batch> batch);
+
+            bool _transfer_ownership() const { return _acquire_pool != VK_NULL_HANDLE; }
+
+            CGE_Device& _device;
+            VkCommandPool _command_pool = VK_NULL_HANDLE;   // transfer family
+            VkCommandPool _acquire_pool = VK_NULL_HANDLE;   // graphics family, if different
+            uint32_t _graphics_family = 0;
+
+            // Batch being recorded, nullptr until the first upload after a submit
+            std::unique_ptr<Batch> _recording;
+            VkDeviceSize _chunk_offset = 0;
+            VkDeviceSize _recorded_bytes = 0;
+
+            // Submitted batches in submission order, and spent ones whose
+            // command buffers, fences and semaphore can be reused
+            std::deque<std::unique_ptr<Batch>> _in_flight;
+            std::vector<std::unique_ptr<Batch>> _free_batches;
+
+            uint64_t _next_batch = 1;
+            uint64_t _completed_batch = 0;
+    };
+
+} // cge
+
+#endif /* CGE_UPLOAD_BATCHER */
@@ -0,0 +1,133 @@
+#pragma once
+#ifndef CGE_VERTEX_FORMAT
+#define CGE_VERTEX_FORMAT
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_PATTERN_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cge {
+
+    // GPU-side vertex layouts a model can be uploaded in.
+    // Import, optimization and the .cgemesh cache always work on the full
+    // precision CGE_Model::Vertex; packing happens when the buffers are created
+    enum class CGE_Vertex_Format : uint32_t {
+        FULL = 0,       // CGE_Model::Vertex, 44 bytes
+        PACKED_SNORM,   // CGE_Packed_Vertex with snorm16 positions, 20 bytes
+        PACKED_HALF,    // CGE_Packed_Vertex with half float positions, 20 bytes
+    };
+
+    static constexpr uint32_t CGE_VERTEX_FORMAT_COUNT = 3;
+
+    // Packed vertex shared by both PACKED formats. They only differ in how
+    // position is stored:
+    //  PACKED_SNORM: snorm16 of (position - center) / extent, so the whole
+    //                mesh bounds get the full 16 bits
+    //  PACKED_HALF:  half float of (position - center), which keeps relative
+    //                precision close to the center of the mesh
+    // Either way the model's dequantization matrix maps it back to object space.
+    // Normals are octahedral encoded, colors are unorm8 and uvs half floats
+    struct CGE_Packed_Vertex {
+        uint16_t position[4];   // xyz + padding so the attribute stays 8 bytes
+        int16_t normal[2];
+        uint8_t color[4];       // rgb + unused alpha
+        uint16_t uv[2];
+    };
+
+    static_assert(sizeof(CGE_Packed_Vertex) == 20, "CGE_Packed_Vertex must stay tightly packed");
+
+    // Size in bytes of the formats used for vertex attributes
+    constexpr uint32_t cge_format_size(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
+            case VK_FORMAT_R32G32B32_SFLOAT:    return 12;
+            case VK_FORMAT_R32G32_SFLOAT:       return 8;
+            case VK_FORMAT_R16G16B16A16_SFLOAT: return 8;
+            case VK_FORMAT_R16G16B16A16_SNORM:  return 8;
+            case VK_FORMAT_R16G16B16A16_UNORM:  return 8;
+            case VK_FORMAT_R16G16_SFLOAT:       return 4;
+            case VK_FORMAT_R16G16_SNORM:        return 4;
+            case VK_FORMAT_R16G16_UNORM:        return 4;
+            case VK_FORMAT_R8G8B8A8_UNORM:      return 4;
+            case VK_FORMAT_R8G8_SNORM:          return 2;
+            default:                            return 0;
+        }
+    }
+
+    // One shader input: location, format and byte offset in the vertex
+    template <uint32_t Location, VkFormat Format, uint32_t Offset>
+    struct CGE_Vertex_Attribute {
+        static constexpr uint32_t LOCATION = Location;
+        static constexpr uint32_t SIZE = cge_format_size(Format);
+        static constexpr uint32_t END = Offset + SIZE;
+
+        static_assert(SIZE != 0, "unsupported vertex attribute format");
+
+        static constexpr VkVertexInputAttributeDescription description(uint32_t binding) {
+            return {Location, binding, Format, Offset};
+        }
+    };
+
+    // Compile-time description of a single interleaved vertex binding.
+    // The Vulkan binding and attribute descriptions are generated from the
+    // attribute list, and every attribute is checked to fit inside the vertex
+    template <typename VertexType, typename... Attributes>
+    struct CGE_Vertex_Layout {
+        static constexpr uint32_t BINDING = 0;
+        static constexpr uint32_t STRIDE = sizeof(VertexType);
+
+        static_assert(((Attributes::END <= STRIDE) && ...), "vertex attribute overruns the vertex stride");
+
+        static constexpr VkVertexInputBindingDescription binding{BINDING, STRIDE, VK_VERTEX_INPUT_RATE_VERTEX};
+
+        static constexpr std::array<VkVertexInputAttributeDescription, sizeof...(Attributes)> attributes{{
+            Attributes::description(BINDING)...
+        }};
+
+        static std::vector<VkVertexInputBindingDescription> get_binding_description() {
+            return {binding};
+        }
+
+        static std::vector<VkVertexInputAttributeDescription> get_attribute_description() {
+            return {attributes.begin(), attributes.end()};
+        }
+    };
+
+    // Shader locations are the same for every format, see shaders/vert/packed.vert
+    template <VkFormat PositionFormat>
+    using CGE_Packed_Vertex_Layout = CGE_Vertex_Layout<
+        CGE_Packed_Vertex,
+        CGE_Vertex_Attribute<0, PositionFormat,                offsetof(CGE_Packed_Vertex, position)>,
+        CGE_Vertex_Attribute<1, VK_FORMAT_R8G8B8A8_UNORM,      offsetof(CGE_Packed_Vertex, color)>,
+        CGE_Vertex_Attribute<2, VK_FORMAT_R16G16_SNORM,        offsetof(CGE_Packed_Vertex, normal)>,
+        CGE_Vertex_Attribute<3, VK_FORMAT_R16G16_SFLOAT,       offsetof(CGE_Packed_Vertex, uv)>>;
+
+    using CGE_Packed_Snorm_Layout = CGE_Packed_Vertex_Layout<VK_FORMAT_R16G16B16A16_SNORM>;
+    using CGE_Packed_Half_Layout = CGE_Packed_Vertex_Layout<VK_FORMAT_R16G16B16A16_SFLOAT>;
+
+    //
+    // Encoders used when packing vertices
+    //
+
+    // IEEE 754 binary16, round to nearest even. Overflow becomes infinity
+    uint16_t cge_pack_half(float value);
+    float cge_unpack_half(uint16_t value);
+
+    // Float in [-1, 1] to snorm16 / [0, 1] to unorm8, clamping out of range values
+    int16_t cge_pack_snorm16(float value);
+    uint8_t cge_pack_unorm8(float value);
+
+    // Octahedral normal encoding (Meyer et al. 2010), components in [-1, 1].
+    // A zero vector encodes as +z
+    glm::vec2 cge_encode_octahedral(glm::vec3 normal);
+    glm::vec3 cge_decode_octahedral(glm::vec2 encoded);
+
+} // cge
+
+#endif /* CGE_VERTEX_FORMAT */
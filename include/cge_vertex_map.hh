@@ -0,0 +1,117 @@
+#pragma once
+#ifndef CGE_VERTEX_MAP
+#define CGE_VERTEX_MAP
+
+#include "cge_model.hh"
+#include "utils.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace cge {
+
+    // Open-addressing hash set used to deduplicate CGE_Model::Vertex during import.
+    // Slots hold an index into the caller's vertex array plus a 32 bit hash tag,
+    // so the table is one flat allocation of 8 byte slots and each lookup or
+    // insert walks a single linear probe sequence.
+    // Vertices are hashed and compared byte-wise, which means -0.0 and 0.0 are
+    // treated as different values (and identical NaNs as equal)
+    class CGE_Vertex_Map {
+        public:
+            static_assert(sizeof(CGE_Model::Vertex) == 11 * sizeof(float),
+                          "byte-wise hashing requires a Vertex without padding");
+
+            CGE_Vertex_Map() = default;
+            explicit CGE_Vertex_Map(size_t expected_count) { reserve(expected_count); }
+
+            // Size the table so expected_count unique vertices fit without a rehash
+            // Passing the index count is always enough, since every corner is
+            // at most one new vertex
+            void reserve(size_t expected_count) {
+                size_t capacity = 16;
+                while (capacity * MAX_LOAD_NUM < expected_count * MAX_LOAD_DEN) {
+                    capacity <<= 1;
+                }
+                if (capacity > _slots.size()) {
+                    _rehash(capacity);
+                }
+            }
+
+            // Return the index of vertex in vertices, appending it first if it is new
+            uint32_t find_or_insert(const CGE_Model::Vertex& vertex, std::vector<CGE_Model::Vertex>& vertices) {
+                if ((_count + 1) * MAX_LOAD_DEN > _slots.size() * MAX_LOAD_NUM) {
+                    _rehash(_slots.empty() ? 16 : _slots.size() * 2);
+                }
+
+                uint32_t tag = _tag(vertex);
+                size_t mask = _slots.size() - 1;
+                size_t position = tag & mask;
+
+                while (true) {
+                    Slot& slot = _slots[position];
+                    if (slot.index == EMPTY) {
+                        slot.index = static_cast<uint32_t>(vertices.size());
+                        slot.tag = tag;
+                        vertices.push_back(vertex);
+                        _count++;
+                        return slot.index;
+                    }
+                    if (slot.tag == tag
+                        && std::memcmp(&vertices[slot.index], &vertex, sizeof(vertex)) == 0) {
+                        return slot.index;
+                    }
+                    position = (position + 1) & mask;
+                }
+            }
+
+            size_t size() const { return _count; }
+            size_t capacity() const { return _slots.size(); }
+
+            void clear() {
+                _slots.clear();
+                _count = 0;
+            }
+
+        private:
+            struct Slot {
+                uint32_t index;
+                uint32_t tag;
+            };
+
+            static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+
+            // Keep the load factor at or below 3/4
+            static constexpr size_t MAX_LOAD_NUM = 3;
+            static constexpr size_t MAX_LOAD_DEN = 4;
+
+            // The probe start is derived from the stored tag, so growing the
+            // table never has to rehash the vertices themselves
+            static uint32_t _tag(const CGE_Model::Vertex& vertex) {
+                uint64_t hash = hash_bytes(&vertex, sizeof(vertex));
+                return static_cast<uint32_t>(hash ^ (hash >> 32));
+            }
+
+            void _rehash(size_t capacity) {
+                std::vector<Slot> old_slots(capacity, Slot{EMPTY, 0});
+                old_slots.swap(_slots);
+
+                size_t mask = _slots.size() - 1;
+                for (const Slot& slot : old_slots) {
+                    if (slot.index == EMPTY) continue;
+
+                    size_t position = slot.tag & mask;
+                    while (_slots[position].index != EMPTY) {
+                        position = (position + 1) & mask;
+                    }
+                    _slots[position] = slot;
+                }
+            }
+
+            std::vector<Slot> _slots;
+            size_t _count = 0;
+    };
+
+} // cge
+
+#endif /* CGE_VERTEX_MAP */
@@ -5,6 +5,9 @@
 
 namespace cge {
 
+    // Marks entities that KeyboardMovementController::update moves
+    struct KeyboardControlComponent {};
+
     class KeyboardMovementController {
         public:
             struct KeyMappings {
@@ -20,13 +23,25 @@ namespace cge {
                 int look_down= GLFW_KEY_DOWN;
             };
 
-            void move_in_plane_xz(GLFWwindow* window, float dt, CGE_Game_Object& game_object);
+            void move_in_plane_xz(GLFWwindow* window, float dt, TransformComponent& transform);
+
+            // Move every entity with a TransformComponent and a
+            // KeyboardControlComponent. Keys are read once for all of them
+            void update(GLFWwindow* window, float dt, CGE_World& world);
 
             KeyMappings keys{};
             float move_speed{3.f};
             float look_speed{1.5f};
 
         private:
+            // Key state as look and movement axes; move is along the
+            // forward, right and up directions of each transform
+            struct Input {
+                glm::vec3 rotate{0.f};
+                glm::vec3 move{0.f};
+            };
 
+            Input _read_input(GLFWwindow* window) const;
+            void _apply(const Input& input, float dt, TransformComponent& transform) const;
     };
 }
@@ -2,14 +2,18 @@
 #ifndef SIMPLE_RENDER_SYSTEM 
 #define SIMPLE_RENDER_SYSTEM 
 
+#include <array>
 #include <memory>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 #include "cge_device.hh"
+#include "cge_buffer.hh"
 #include "cge_camera.hh"
 #include "cge_pipeline.hh"
+#include "cge_ecs.hh"
 #include "cge_game_object.hh"
 #include "cge_frame_info.hh"
+#include "cge_vertex_format.hh"
 
 namespace cge {
     class SimpleRenderSystem {
@@ -19,18 +23,57 @@ namespace cge {
 
             SimpleRenderSystem(const SimpleRenderSystem&) = delete;
             SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
+ 
+            // Draw every entity with a TransformComponent and a ModelComponent
             void render_game_objects(
                     FrameInfo &frame_info,
-                    std::vector<CGE_Game_Object> &game_objects);
-            
+                    CGE_World &world);
+
+            // Also drop meshlets whose normal cone faces away from the camera.
+            // The default pipeline does not cull back faces, so only enable
+            // this when every model drawn is closed
+            void set_cluster_backface_culling(bool enabled) { _cluster_backface_culling = enabled; }
+
+            // Largest screen space error a level of detail may have before a
+            // finer one is drawn, as a fraction of the viewport half height.
+            // The default is about one pixel at 1080p
+            void set_lod_threshold(float threshold) { _lod_threshold = threshold; }
+
+            // Draw with shaders/vert/pulling.vert, which reads vertices through
+            // buffer device addresses instead of the vertex input stage. One
+            // pipeline then serves every vertex format and no vertex buffers
+            // are bound. On by default when the device supports it; ignored
+            // otherwise
+            void set_vertex_pulling(bool enabled) { _vertex_pulling = enabled; }
+            bool uses_vertex_pulling() const { return _vertex_pulling && _pulling_pipeline; }
+
+            // Relative band around the threshold that keeps the current level,
+            // so objects near the boundary do not switch every frame
+            static constexpr float LOD_HYSTERESIS = 0.25f;
+
         private:
             void _create_pipeline_layout();
             void _create_pipeline(VkRenderPass render_pass);
+            void _create_pulling_pipeline(VkRenderPass render_pass);
+            void _create_placeholder_model();
+            CGE_Model* _resolve_model(ModelComponent& model, glm::mat4& model_matrix) const;
+            uint32_t _select_lod(ModelComponent& model, const glm::mat4& model_matrix, const CGE_Camera& camera) const;
 
             CGE_Device& _device;
 
             VkPipelineLayout _pipeline_layout;
-            std::unique_ptr<CGE_Pipeline> _pipeline;
+            // One pipeline per vertex format, indexed by CGE_Vertex_Format
+            std::array<std::unique_ptr<CGE_Pipeline>, CGE_VERTEX_FORMAT_COUNT> _pipelines;
+
+            // Vertex pulling path, only created with buffer device address
+            VkPipelineLayout _pulling_pipeline_layout = VK_NULL_HANDLE;
+            std::unique_ptr<CGE_Pipeline> _pulling_pipeline;
+            bool _vertex_pulling = true;
+
+            // Unit cube drawn over the bounds of models that are still loading
+            std::unique_ptr<CGE_Model> _placeholder_model;
+            bool _cluster_backface_culling = false;
+            float _lod_threshold = 0.002f;
     };
 }
 
@@ -1,5 +1,8 @@
 #pragma once
 #include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
 
 namespace cge {
 
@@ -8,4 +11,42 @@ namespace cge {
         seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
         (hash_combine(seed, rest), ...);
     };
+
+    // 64x64 -> 128 bit multiply folded back to 64 bits (wyhash "mum")
+    inline uint64_t hash_mix(uint64_t a, uint64_t b) {
+        __uint128_t r = static_cast<__uint128_t>(a) * b;
+        return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+    }
+
+    // Hash a raw byte range 16 bytes at a time
+    // Used for file content keys and for hashing POD structs byte-wise
+    inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0) {
+        constexpr uint64_t k0 = 0xa0761d6478bd642fULL;
+        constexpr uint64_t k1 = 0xe7037ed1a0b428dbULL;
+        constexpr uint64_t k2 = 0x8ebc6af09c88c6e3ULL;
+
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        size_t remaining = size;
+        seed ^= hash_mix(seed ^ k0, k1);
+
+        while (remaining >= 16) {
+            uint64_t a, b;
+            std::memcpy(&a, p, 8);
+            std::memcpy(&b, p + 8, 8);
+            seed = hash_mix(a ^ k1, b ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+
+        uint64_t a = 0, b = 0;
+        if (remaining > 8) {
+            std::memcpy(&a, p, 8);
+            std::memcpy(&b, p + 8, remaining - 8);
+        } else if (remaining > 0) {
+            std::memcpy(&a, p, remaining);
+        }
+
+        seed = hash_mix(a ^ k1, b ^ seed);
+        return hash_mix(seed ^ k2, static_cast<uint64_t>(size) ^ k1);
+    }
 }
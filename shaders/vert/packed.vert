@@ -0,0 +1,41 @@
+#version 450
+
+// Vertex shader for CGE_Packed_Vertex (CGE_Vertex_Format::PACKED_SNORM / PACKED_HALF).
+// The vertex input stage already expands snorm16, half and unorm8 data to
+// floats; position is in quantized space and push.transform includes the
+// model's dequantization matrix, normal is octahedral encoded
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec2 normalOct;
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec3 fragColor;
+
+layout(push_constant) uniform Push {
+    mat4 transform; // projection * view * model * dequantization
+    mat4 normalMatrix;
+} push;
+
+// simulates light source that is infinitely far from the object
+// this is because it is a vector rather than detecting it from a position
+const vec3 DIRECTION_TO_LIGHT = normalize(vec3(1.0, -3.0, -1.0)); 
+
+const float AMBIENT = 0.02;
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    gl_Position = push.transform * vec4(position, 1.0);
+
+    vec3 normal = decodeOctahedral(normalOct);
+    vec3 normalWorldSpace = normalize(mat3(push.normalMatrix) * normal);
+    float lightIntensity = AMBIENT + max(dot(normalWorldSpace, DIRECTION_TO_LIGHT), 0);
+
+    fragColor = lightIntensity * color;
+}
@@ -0,0 +1,80 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+
+// Programmable vertex pulling for every CGE_Vertex_Format. There is no vertex
+// input state: vertices are read from the model's vertex buffer through its
+// device address and decoded here, so one pipeline draws all formats.
+// gl_VertexIndex includes the draw's vertex offset, which places pooled
+// models within their shared buffer
+layout(location = 0) out vec3 fragColor;
+
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer VertexWords {
+    uint words[];
+};
+
+// Same values as CGE_Vertex_Format
+const uint FORMAT_FULL = 0;
+const uint FORMAT_PACKED_SNORM = 1;
+const uint FORMAT_PACKED_HALF = 2;
+
+layout(push_constant) uniform Push {
+    mat4 transform;         // projection * view * model * dequantization
+    vec4 normalMatrix[3];   // columns of the normal matrix
+    VertexWords vertices;
+    uint format;
+    uint stride;            // vertex size in 32-bit words
+} push;
+
+// simulates light source that is infinitely far from the object
+// this is because it is a vector rather than detecting it from a position
+const vec3 DIRECTION_TO_LIGHT = normalize(vec3(1.0, -3.0, -1.0)); 
+
+const float AMBIENT = 0.02;
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec3 loadVec3(uint word) {
+    return uintBitsToFloat(uvec3(
+        push.vertices.words[word],
+        push.vertices.words[word + 1],
+        push.vertices.words[word + 2]));
+}
+
+void main() {
+    uint base = uint(gl_VertexIndex) * push.stride;
+
+    vec3 position;
+    vec3 color;
+    vec3 normal;
+    if (push.format == FORMAT_FULL) {
+        // CGE_Model::Vertex: position, color, normal, uv as floats
+        position = loadVec3(base);
+        color = loadVec3(base + 3);
+        normal = loadVec3(base + 6);
+    } else {
+        // CGE_Packed_Vertex: position xyzw, normal, color, uv
+        uint xy = push.vertices.words[base];
+        uint zw = push.vertices.words[base + 1];
+        if (push.format == FORMAT_PACKED_SNORM) {
+            position = vec3(unpackSnorm2x16(xy), unpackSnorm2x16(zw).x);
+        } else {
+            position = vec3(unpackHalf2x16(xy), unpackHalf2x16(zw).x);
+        }
+        normal = decodeOctahedral(unpackSnorm2x16(push.vertices.words[base + 2]));
+        color = unpackUnorm4x8(push.vertices.words[base + 3]).rgb;
+    }
+
+    gl_Position = push.transform * vec4(position, 1.0);
+
+    mat3 normalMatrix = mat3(push.normalMatrix[0].xyz, push.normalMatrix[1].xyz, push.normalMatrix[2].xyz);
+    vec3 normalWorldSpace = normalize(normalMatrix * normal);
+    float lightIntensity = AMBIENT + max(dot(normalWorldSpace, DIRECTION_TO_LIGHT), 0);
+
+    fragColor = lightIntensity * color;
+}
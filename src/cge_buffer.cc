@@ -1,5 +1,6 @@
 #include "cge_buffer.hh"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <vulkan/vulkan_core.h>
@@ -29,7 +30,8 @@ namespace cge {
         uint32_t instance_count,
         VkBufferUsageFlags usage_flags,
         VkMemoryPropertyFlags memory_property_flags,
-        VkDeviceSize min_offset_allignment
+        VkDeviceSize min_offset_allignment,
+        VkMemoryPropertyFlags preferred_memory_property_flags
     ) : _device{device},
         _instance_size{instance_size},
         _instance_count{instance_count},
@@ -38,35 +40,66 @@ namespace cge {
     {
         _alignment_size = get_allignment(instance_size, min_offset_allignment); 
         _buffer_size = _alignment_size * instance_count;
-        _device.createBuffer(_buffer_size, _usage_flags, _memory_property_flags, _buffer, _memory);
+        _device.createBuffer(
+            _buffer_size,
+            _usage_flags,
+            _memory_property_flags,
+            _buffer,
+            _memory,
+            preferred_memory_property_flags);
+        _memory_property_flags = _device.memoryAllocator().get_memory_type_flags(_memory.memory_type);
+
+        if (_usage_flags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR) {
+            _device_address = _device.getBufferDeviceAddress(_buffer);
+        }
     }
 
     CGE_Buffer::~CGE_Buffer() {
         unmap();
         vkDestroyBuffer(_device.device(), _buffer, nullptr);
-        vkFreeMemory(_device.device(), _memory, nullptr);
+        _device.freeMemory(_memory);
     }
 
     // Map a range of memory of this buffer. If successful,
     // _mapped points to the specified buffer range
+    // Host visible memory stays mapped by the allocator, so this only
+    // hands out the address
     VkResult
     CGE_Buffer::map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(_buffer && _memory && "Called map on buffer before create");
-        return vkMapMemory(_device.device(), _memory, offset, size, 0, &_mapped);
+        assert(_buffer && _memory.memory && "Called map on buffer before create");
+        assert((size == VK_WHOLE_SIZE || offset + size <= _buffer_size) && "Mapped range is outside the buffer");
+        if (!_memory.mapped)
+            return VK_ERROR_MEMORY_MAP_FAILED;
+
+        _mapped = static_cast<char*>(_memory.mapped) + offset;
+        return VK_SUCCESS;
     }
 
-    // Unmap a mapped memory range
-    // Does not return a result as vkUnmapMemory cannot fail
+    // Forget the mapped address
+    // The memory itself is unmapped when the allocator frees its block
     void
     CGE_Buffer::unmap() {
-        if (_mapped) {
-            vkUnmapMemory(_device.device(), _memory);
-            _mapped = nullptr;
+        _mapped = nullptr;
+    }
+
+    // Translate a range of this buffer into a range of its device memory
+    // object. VK_WHOLE_SIZE covers the rest of the allocation, which the
+    // allocator keeps a multiple of nonCoherentAtomSize
+    VkMappedMemoryRange
+    CGE_Buffer::_memory_range(VkDeviceSize size, VkDeviceSize offset) const {
+        VkMappedMemoryRange mapped_range = {};
+        mapped_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        mapped_range.memory = _memory.memory;
+        mapped_range.offset = _memory.offset + offset;
+        mapped_range.size = size;
+        if (size == VK_WHOLE_SIZE && _memory.block) {
+            mapped_range.size = _memory.allocated_size - offset;
         }
+        return mapped_range;
     }
 
     // Copies the specified data to the mapped buffer
-    // Default value writes whole buffer range
+    // Default value writes the rest of the buffer from offset
     // @param data Pointer to the data to copy
     // @param size (optional) Size of the data to copy
     // @param offset (optional) Byte offset from beginning of mapped region
@@ -75,12 +108,75 @@ namespace cge {
         assert(_mapped && "Cannot copy to unmapped buffer");
 
         if (size == VK_WHOLE_SIZE) {
-            memcpy(_mapped, data, _buffer_size);
-        } else {
-            char *mem_offset = (char*)_mapped;
-            mem_offset += offset;
-            memcpy(mem_offset, data, size);
+            size = _buffer_size - offset;
+        }
+        assert(offset + size <= _buffer_size && "Write past the end of the buffer");
+
+        char *mem_offset = (char*)_mapped;
+        mem_offset += offset;
+        memcpy(mem_offset, data, size);
+        mark_dirty(size, offset);
+    }
+
+    // Remember a written range for the next flush_dirty
+    // Sequential writes extend the last range instead of adding one
+    void
+    CGE_Buffer::mark_dirty(VkDeviceSize size, VkDeviceSize offset) {
+        if (_is_coherent())
+            return;
+
+        VkDeviceSize end = size == VK_WHOLE_SIZE ? _buffer_size : offset + size;
+        if (!_dirty_ranges.empty()) {
+            auto& last = _dirty_ranges.back();
+            if (offset <= last.second && end >= last.first) {
+                last.first = std::min(last.first, offset);
+                last.second = std::max(last.second, end);
+                return;
+            }
         }
+        _dirty_ranges.emplace_back(offset, end);
+    }
+
+    // Flush all dirty ranges with a single vkFlushMappedMemoryRanges
+    // @return result of the flush call
+    VkResult
+    CGE_Buffer::flush_dirty() {
+        if (_dirty_ranges.empty())
+            return VK_SUCCESS;
+
+        std::sort(_dirty_ranges.begin(), _dirty_ranges.end());
+
+        // Round in device memory coordinates; the end of the allocation is
+        // always a valid end even when it is not a whole atom
+        VkDeviceSize atom = std::max<VkDeviceSize>(_device.properties.limits.nonCoherentAtomSize, 1);
+        VkDeviceSize memory_end = _memory.offset + _memory.allocated_size;
+
+        _flush_ranges.clear();
+        for (const auto& range : _dirty_ranges) {
+            VkDeviceSize begin = (_memory.offset + range.first) & ~(atom - 1);
+            VkDeviceSize end = std::min((_memory.offset + range.second + atom - 1) & ~(atom - 1), memory_end);
+
+            if (!_flush_ranges.empty()) {
+                VkMappedMemoryRange& last = _flush_ranges.back();
+                if (begin <= last.offset + last.size) {
+                    last.size = std::max(last.offset + last.size, end) - last.offset;
+                    continue;
+                }
+            }
+
+            VkMappedMemoryRange mapped_range = {};
+            mapped_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            mapped_range.memory = _memory.memory;
+            mapped_range.offset = begin;
+            mapped_range.size = end - begin;
+            _flush_ranges.push_back(mapped_range);
+        }
+        _dirty_ranges.clear();
+
+        return vkFlushMappedMemoryRanges(
+            _device.device(),
+            static_cast<uint32_t>(_flush_ranges.size()),
+            _flush_ranges.data());
     }
 
 
@@ -92,22 +188,14 @@ namespace cge {
     // @return result of the flush call
     VkResult
     CGE_Buffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mapped_range = {};
-        mapped_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mapped_range.memory = _memory;
-        mapped_range.offset = offset;
-        mapped_range.size = size;
+        VkMappedMemoryRange mapped_range = _memory_range(size, offset);
         return vkFlushMappedMemoryRanges(_device.device(), 1, &mapped_range);
     }
 
     // Invalidate a memory range of the buffer to make it visible to the host
     VkResult
     CGE_Buffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mapped_range = {};
-        mapped_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mapped_range.memory = _memory;
-        mapped_range.offset = offset;
-        mapped_range.size = size;
+        VkMappedMemoryRange mapped_range = _memory_range(size, offset);
         return vkInvalidateMappedMemoryRanges(_device.device(), 1, &mapped_range);
     }
 
@@ -54,9 +54,13 @@ void DestroyDebugUtilsMessengerEXT(
         pickPhysicalDevice();
         createLogicalDevice();
         createCommandPool();
+        allocator_ = std::make_unique<CGE_Memory_Allocator>(physicalDevice, device_, bufferDeviceAddressSupported_);
+        stagingRing_ = std::make_unique<CGE_Staging_Ring>(*this, STAGING_RING_SIZE);
     }
 
     CGE_Device::~CGE_Device() {
+        stagingRing_.reset();
+        allocator_.reset();
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
       
@@ -79,7 +83,10 @@ void DestroyDebugUtilsMessengerEXT(
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        // 1.1 so the core *2 queries are available on devices that are 1.1
+        // or newer; each feature that needs them also checks the device's
+        // own apiVersion, since the instance version does not raise it
+        appInfo.apiVersion = VK_API_VERSION_1_1;
     
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -138,6 +145,9 @@ void DestroyDebugUtilsMessengerEXT(
     
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+        if (indices.transferFamilyHasValue) {
+            uniqueQueueFamilies.insert(indices.transferFamily);
+        }
     
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -149,8 +159,13 @@ void DestroyDebugUtilsMessengerEXT(
             queueCreateInfos.push_back(queueCreateInfo);
         }
     
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        features = deviceFeatures;
     
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -158,9 +173,42 @@ void DestroyDebugUtilsMessengerEXT(
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
     
+        // Optional extensions are enabled when the device has them
+        std::vector<const char *> enabledExtensions = deviceExtensions;
+        // The budget is read through vkGetPhysicalDeviceMemoryProperties2,
+        // which is only core on 1.1 devices
+        bool deviceIsVulkan11 = properties.apiVersion >= VK_API_VERSION_1_1;
+        memoryBudgetSupported_ = deviceIsVulkan11
+            && isDeviceExtensionAvailable(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (memoryBudgetSupported_) {
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+
+        // Buffer device address needs both the extension and its feature bit,
+        // queried with vkGetPhysicalDeviceFeatures2 (core on 1.1 devices)
+        VkPhysicalDeviceBufferDeviceAddressFeaturesKHR bufferDeviceAddressFeatures{};
+        bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR;
+        if (deviceIsVulkan11 && isDeviceExtensionAvailable(physicalDevice, VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME)) {
+            VkPhysicalDeviceFeatures2 supportedFeatures2{};
+            supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            supportedFeatures2.pNext = &bufferDeviceAddressFeatures;
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+
+            bufferDeviceAddressSupported_ = bufferDeviceAddressFeatures.bufferDeviceAddress == VK_TRUE;
+        }
+        if (bufferDeviceAddressSupported_) {
+            enabledExtensions.push_back(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+
+            // Only the address itself, not capture replay or multi device
+            bufferDeviceAddressFeatures.pNext = nullptr;
+            bufferDeviceAddressFeatures.bufferDeviceAddressCaptureReplay = VK_FALSE;
+            bufferDeviceAddressFeatures.bufferDeviceAddressMultiDevice = VK_FALSE;
+            createInfo.pNext = &bufferDeviceAddressFeatures;
+        }
+
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
     
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -175,8 +223,24 @@ void DestroyDebugUtilsMessengerEXT(
             throw std::runtime_error("failed to create logical device!");
         }
     
+        if (bufferDeviceAddressSupported_) {
+            getBufferDeviceAddress_ = reinterpret_cast<PFN_vkGetBufferDeviceAddressKHR>(
+                    vkGetDeviceProcAddr(device_, "vkGetBufferDeviceAddressKHR"));
+            bufferDeviceAddressSupported_ = getBufferDeviceAddress_ != nullptr;
+        }
+
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+        // Fall back to the graphics queue, e.g. on lavapipe's single family
+        transferFamily_ = indices.graphicsFamily;
+        transferQueue_ = graphicsQueue_;
+        if (indices.transferFamilyHasValue) {
+            transferFamily_ = indices.transferFamily;
+            vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+        }
+        std::cout << "transfer queue family: " << transferFamily_
+                  << (hasSeparateTransferQueue() ? "" : " (shared with graphics)") << std::endl;
     }
 
     void CGE_Device::createCommandPool() {
@@ -297,6 +361,25 @@ void DestroyDebugUtilsMessengerEXT(
         }
     }
     
+    bool CGE_Device::isDeviceExtensionAvailable(VkPhysicalDevice device, const char *name) {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(
+                device,
+                nullptr,
+                &extensionCount,
+                availableExtensions.data());
+    
+        for (const auto &extension : availableExtensions) {
+            if (strcmp(extension.extensionName, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
     bool CGE_Device::checkDeviceExtensionSupport(VkPhysicalDevice device) {
         uint32_t extensionCount;
         vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -344,6 +427,30 @@ void DestroyDebugUtilsMessengerEXT(
     
             i++;
         }
+
+        if (!indices.graphicsFamilyHasValue) {
+            return indices;
+        }
+
+        // Transfer family: a transfer-only family (DMA engine) if there is one,
+        // otherwise any other family that can copy. Graphics and compute
+        // families support transfers implicitly
+        const VkQueueFlags copyCapable = VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+        for (uint32_t family = 0; family < queueFamilyCount; family++) {
+            const VkQueueFamilyProperties &queueFamily = queueFamilies[family];
+            if (family == indices.graphicsFamily || queueFamily.queueCount == 0 || !(queueFamily.queueFlags & copyCapable)) {
+                continue;
+            }
+
+            bool dedicated = !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT));
+            if (dedicated || !indices.transferFamilyHasValue) {
+                indices.transferFamily = family;
+                indices.transferFamilyHasValue = true;
+            }
+            if (dedicated) {
+                break;
+            }
+        }
     
         return indices;
     }
@@ -390,17 +497,78 @@ void DestroyDebugUtilsMessengerEXT(
         throw std::runtime_error("failed to find supported format!");
     }
     
-    uint32_t CGE_Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-        VkPhysicalDeviceMemoryProperties memProperties;
-        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-            if ((typeFilter & (1 << i)) &&
-                    (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-                return i;
+    // Allocations are tagged by what the resource is used for, so leaks and
+    // budget use can be reported per category
+    static CGE_Memory_Category bufferCategory(VkBufferUsageFlags usage) {
+        if (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)) {
+            return CGE_Memory_Category::UNIFORM;
+        }
+        if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+            return CGE_Memory_Category::GEOMETRY;
+        }
+        if (usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) {
+            return CGE_Memory_Category::STAGING;
+        }
+        return CGE_Memory_Category::OTHER;
+    }
+    
+    static CGE_Memory_Category imageCategory(VkImageUsageFlags usage) {
+        if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+            return CGE_Memory_Category::DEPTH;
+        }
+        if (usage & VK_IMAGE_USAGE_SAMPLED_BIT) {
+            return CGE_Memory_Category::TEXTURE;
+        }
+        return CGE_Memory_Category::OTHER;
+    }
+    
+    VkDeviceAddress CGE_Device::getBufferDeviceAddress(VkBuffer buffer) {
+        if (!bufferDeviceAddressSupported_) {
+            return 0;
+        }
+
+        VkBufferDeviceAddressInfoKHR addressInfo{};
+        addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
+        addressInfo.buffer = buffer;
+        return getBufferDeviceAddress_(device_, &addressInfo);
+    }
+
+    CGE_Memory_Snapshot CGE_Device::memorySnapshot() {
+        CGE_Memory_Snapshot snapshot{};
+        snapshot.categories = allocator_->get_category_stats();
+        snapshot.uploads = allocator_->get_upload_stats();
+
+        auto engineHeaps = allocator_->get_heap_stats();
+        snapshot.heaps.resize(allocator_->get_heap_count());
+        for (uint32_t i = 0; i < snapshot.heaps.size(); i++) {
+            auto &heap = snapshot.heaps[i];
+            heap.size = allocator_->get_heap(i).size;
+            heap.device_local = (allocator_->get_heap(i).flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+            heap.budget = heap.size;
+            heap.usage = engineHeaps[i].allocated_bytes;
+            heap.engine = engineHeaps[i];
+        }
+
+        if (memoryBudgetSupported_) {
+            VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+            budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+            VkPhysicalDeviceMemoryProperties2 memProperties{};
+            memProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+            memProperties.pNext = &budget;
+            vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memProperties);
+
+            snapshot.budget_available = true;
+            for (uint32_t i = 0; i < snapshot.heaps.size(); i++) {
+                snapshot.heaps[i].budget = budget.heapBudget[i];
+                snapshot.heaps[i].usage = budget.heapUsage[i];
             }
         }
+        return snapshot;
+    }
     
-        throw std::runtime_error("failed to find suitable memory type!");
+    uint32_t CGE_Device::findMemoryType(
+            uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties) {
+        return allocator_->find_memory_type(typeFilter, properties, preferredProperties);
     }
     
     void CGE_Device::createBuffer(
@@ -408,7 +576,8 @@ void DestroyDebugUtilsMessengerEXT(
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer &buffer,
-            VkDeviceMemory &bufferMemory) {
+            CGE_Allocation &bufferMemory,
+            VkMemoryPropertyFlags preferredProperties) {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
@@ -422,16 +591,13 @@ void DestroyDebugUtilsMessengerEXT(
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
     
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        bufferMemory = allocator_->allocate(
+                memRequirements,
+                findMemoryType(memRequirements.memoryTypeBits, properties, preferredProperties),
+                true,
+                bufferCategory(usage));
     
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
-        }
-    
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+        vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset);
     }
     
     VkCommandBuffer CGE_Device::beginSingleTimeCommands() {
@@ -509,7 +675,7 @@ void DestroyDebugUtilsMessengerEXT(
             const VkImageCreateInfo &imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage &image,
-            VkDeviceMemory &imageMemory) {
+            CGE_Allocation &imageMemory) {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image!");
         }
@@ -517,16 +683,13 @@ void DestroyDebugUtilsMessengerEXT(
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
     
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-    
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
+        imageMemory = allocator_->allocate(
+                memRequirements,
+                findMemoryType(memRequirements.memoryTypeBits, properties),
+                imageInfo.tiling == VK_IMAGE_TILING_LINEAR,
+                imageCategory(imageInfo.usage));
     
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
@@ -0,0 +1,238 @@
+#include "cge_ecs.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace cge {
+
+    // Component types are shared by every world. An entry is written before
+    // its id is handed out and never changes, so reads need no lock
+    static std::mutex component_mutex;
+    static std::array<CGE_Component_Info, CGE_MAX_COMPONENTS> component_infos;
+    static uint32_t component_count = 0;
+
+    uint32_t
+    cge_register_component(const CGE_Component_Info& info) {
+        std::lock_guard<std::mutex> lock(component_mutex);
+        if (component_count >= CGE_MAX_COMPONENTS) {
+            throw std::runtime_error("Error: too many component types");
+        }
+        component_infos[component_count] = info;
+        return component_count++;
+    }
+
+    const CGE_Component_Info&
+    cge_component_info(uint32_t component) {
+        assert(component < CGE_MAX_COMPONENTS && "Unknown component");
+        return component_infos[component];
+    }
+
+    static unsigned char* allocate_column(const CGE_Component_Info& info, uint32_t capacity) {
+        return static_cast<unsigned char*>(::operator new(
+            info.size * capacity,
+            std::align_val_t{std::max(info.alignment, alignof(std::max_align_t))}));
+    }
+
+    static void free_column(const CGE_Component_Info& info, unsigned char* data) {
+        ::operator delete(data, std::align_val_t{std::max(info.alignment, alignof(std::max_align_t))});
+    }
+
+    //
+    // CGE_Archetype
+    //
+
+    CGE_Archetype::CGE_Archetype(uint64_t mask) : _mask{mask} {
+        for (uint32_t component = 0; component < CGE_MAX_COMPONENTS; component++) {
+            if (!has(component))
+                continue;
+            _column_index[component] = static_cast<uint8_t>(_columns.size());
+            _columns.push_back(Column{component, &cge_component_info(component), nullptr});
+        }
+    }
+
+    CGE_Archetype::~CGE_Archetype() {
+        for (Column& column : _columns) {
+            if (!column.info->trivial) {
+                for (uint32_t row = 0; row < size(); row++) {
+                    column.info->destroy(column.data + row * column.info->size);
+                }
+            }
+            if (column.data) {
+                free_column(*column.info, column.data);
+            }
+        }
+    }
+
+    // Grow every column to capacity rows, moving the existing components
+    void
+    CGE_Archetype::reserve(uint32_t capacity) {
+        if (capacity <= _capacity)
+            return;
+
+        for (Column& column : _columns) {
+            const CGE_Component_Info& info = *column.info;
+            unsigned char* data = allocate_column(info, capacity);
+            if (column.data) {
+                if (info.trivial) {
+                    std::memcpy(data, column.data, info.size * size());
+                } else {
+                    for (uint32_t row = 0; row < size(); row++) {
+                        info.move_construct(data + row * info.size, column.data + row * info.size);
+                        info.destroy(column.data + row * info.size);
+                    }
+                }
+                free_column(info, column.data);
+            }
+            column.data = data;
+        }
+        _entities.reserve(capacity);
+        _capacity = capacity;
+    }
+
+    uint32_t
+    CGE_Archetype::_push(CGE_Entity entity) {
+        if (size() == _capacity) {
+            reserve(std::max<uint32_t>(16, _capacity * 2));
+        }
+        _entities.push_back(entity);
+        return size() - 1;
+    }
+
+    CGE_Entity
+    CGE_Archetype::_swap_remove(uint32_t row, uint64_t destroy_mask) {
+        uint32_t last = size() - 1;
+
+        for (Column& column : _columns) {
+            const CGE_Component_Info& info = *column.info;
+            unsigned char* removed = column.data + row * info.size;
+
+            if (!info.trivial && ((destroy_mask >> column.component) & 1u)) {
+                info.destroy(removed);
+            }
+
+            if (row != last) {
+                unsigned char* moved = column.data + last * info.size;
+                if (info.trivial) {
+                    std::memcpy(removed, moved, info.size);
+                } else {
+                    info.move_construct(removed, moved);
+                    info.destroy(moved);
+                }
+            }
+        }
+
+        CGE_Entity moved{};
+        if (row != last) {
+            moved = _entities[last];
+            _entities[row] = moved;
+        }
+        _entities.pop_back();
+        return moved;
+    }
+
+    //
+    // CGE_World
+    //
+
+    CGE_World::CGE_World() {
+        // Entities without components live in the empty archetype
+        _archetype(0);
+    }
+
+    CGE_World::~CGE_World() {
+    }
+
+    CGE_Archetype&
+    CGE_World::_archetype(uint64_t mask) {
+        auto it = _archetypes_by_mask.find(mask);
+        if (it != _archetypes_by_mask.end())
+            return *it->second;
+
+        auto archetype = std::make_unique<CGE_Archetype>(mask);
+        CGE_Archetype* pointer = archetype.get();
+        _archetypes_by_mask.emplace(mask, std::move(archetype));
+        _archetypes.push_back(pointer);
+        return *pointer;
+    }
+
+    CGE_Entity
+    CGE_World::_allocate_entity(CGE_Archetype& archetype) {
+        CGE_Entity entity{};
+        if (_free_head != CGE_Entity::INVALID) {
+            entity.index = _free_head;
+            _free_head = _records[entity.index].row;
+        } else {
+            entity.index = static_cast<uint32_t>(_records.size());
+            _records.emplace_back();
+        }
+
+        Record& record = _records[entity.index];
+        entity.generation = record.generation;
+        record.archetype = &archetype;
+        record.row = archetype._push(entity);
+        _alive_count++;
+        _structure_version++;
+        return entity;
+    }
+
+    void
+    CGE_World::destroy(CGE_Entity entity) {
+        assert(_iterating == 0 && "Cannot destroy entities while iterating");
+        if (!alive(entity))
+            return;
+
+        Record& record = _records[entity.index];
+        CGE_Entity moved = record.archetype->_swap_remove(record.row);
+        if (moved.valid()) {
+            _records[moved.index].row = record.row;
+        }
+
+        record.archetype = nullptr;
+        record.generation++;
+        record.row = _free_head;
+        _free_head = entity.index;
+        _alive_count--;
+        _structure_version++;
+    }
+
+    // Move the entity's components to the archetype of mask. Components in
+    // both archetypes are moved, the ones only in the old archetype are
+    // destroyed, and the ones only in the new one are left unconstructed
+    void
+    CGE_World::_move_entity(CGE_Entity entity, uint64_t mask) {
+        Record& record = _records[entity.index];
+        CGE_Archetype& source = *record.archetype;
+        CGE_Archetype& target = _archetype(mask);
+        uint32_t source_row = record.row;
+        uint32_t target_row = target._push(entity);
+
+        uint64_t shared = source.get_mask() & mask;
+        for (uint32_t component = 0; component < CGE_MAX_COMPONENTS; component++) {
+            if (!((shared >> component) & 1u))
+                continue;
+
+            const CGE_Component_Info& info = cge_component_info(component);
+            void* from = source._component(component, source_row);
+            void* to = target._component(component, target_row);
+            if (info.trivial) {
+                std::memcpy(to, from, info.size);
+            } else {
+                info.move_construct(to, from);
+                info.destroy(from);
+            }
+        }
+
+        CGE_Entity moved = source._swap_remove(source_row, ~shared);
+        if (moved.valid()) {
+            _records[moved.index].row = source_row;
+        }
+
+        record.archetype = &target;
+        record.row = target_row;
+        _structure_version++;
+    }
+
+} // cge
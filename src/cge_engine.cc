@@ -50,38 +50,17 @@ namespace cge {
     //
     void
     CGE_Engine::_run() {
-        std::vector<std::unique_ptr<CGE_Buffer>> ubo_buffers(CGE_SwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (size_t i = 0; i < ubo_buffers.size(); i++) {
-            ubo_buffers[i] = std::make_unique<CGE_Buffer>(
-                _device,
-                sizeof(Global_Ubo),
-                1,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-            );
-
-            ubo_buffers[i]->map();
-        }
-
-//        CGE_Buffer global_ubo {
-//            _device,
-//            sizeof(Global_Ubo),
-//            CGE_SwapChain::MAX_FRAMES_IN_FLIGHT,
-//            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-//            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-//            min_offset_alignment
-//        };
-//         global_ubo.map();
-
         SimpleRenderSystem simple_render_system {this->_device, this->_renderer.get_swap_chain_render_pass()};
         CGE_Camera camera{};
         // camera.set_view_direction(glm::vec3(0.f), glm::vec3(0.5f, 0.f, 1.f));
         camera.set_view_target(glm::vec3(-1.f, -2.f, 2.f), glm::vec3(0.f, 0.f, 2.5f));
         
-        auto viewer_object = CGE_Game_Object::_create_game_object(); // stores camera state
+        // Stores camera state
+        CGE_Entity viewer = this->_world.create(TransformComponent{}, KeyboardControlComponent{});
         KeyboardMovementController camera_controller{};
         
         auto current_time = std::chrono::high_resolution_clock::now();
+        float memory_report_timer = 0.f;
 
         while (!this->_window._should_close()) {
             glfwPollEvents();
@@ -90,8 +69,9 @@ namespace cge {
             float frame_time = std::chrono::duration<float, std::chrono::seconds::period>(new_time - current_time).count();
             current_time = new_time;
 
-            camera_controller.move_in_plane_xz(_window.get_glfw_window(), frame_time, viewer_object);
-            camera.set_view_xyz(viewer_object.transform.translation, viewer_object.transform.rotation);
+            camera_controller.update(_window.get_glfw_window(), frame_time, this->_world);
+            const TransformComponent& viewer_transform = *this->_world.get<TransformComponent>(viewer);
+            camera.set_view_xyz(viewer_transform.get_translation(), viewer_transform.get_rotation());
 
             float aspect = this->_renderer.get_aspect_ratio();
             camera.set_perspective_projection(
@@ -101,27 +81,49 @@ namespace cge {
                 10.F
                 );
 
+            // World matrices of attached objects whose transform or parent moved
+            this->_scene_graph.update(this->_world);
+
+            // Submit and retire streamed model uploads
+            this->_model_loader.update();
+
             if (auto command_buffer = this->_renderer.begin_frame()) {
                 int frame_index = _renderer.get_current_frame_index();
+                this->_frame_ring.begin_frame(frame_index);
+                this->_geometry_pool.begin_frame(frame_index);
                 FrameInfo frame_info {
                     frame_index,
                     frame_time,
                     command_buffer,
-                    camera
+                    camera,
+                    this->_frame_ring,
+                    this->_renderer.get_frame_arena()
                 };
 
                 // Update
                 Global_Ubo ubo{};
                 ubo.projectionView = camera.get_projection_matrix() * camera.get_view_matrix();
-                ubo_buffers[frame_index]->write_to_buffer(&ubo);
-                ubo_buffers[frame_index]->flush();
+                auto global_ubo = this->_frame_ring.write(&ubo, sizeof(Global_Ubo));
+                assert(global_ubo.valid() && "Frame ring too small for the global ubo");
 
                 // Render
                 this->_renderer.begin_swap_chain_render_pass(command_buffer);
-                simple_render_system.render_game_objects(frame_info, this->_game_objects);
+                simple_render_system.render_game_objects(frame_info, this->_world);
                 this->_renderer.end_swap_chain_render_pass(command_buffer);
+                this->_frame_ring.flush();
                 this->_renderer.end_frame();
             }
+
+            memory_report_timer += frame_time;
+            if (MEMORY_REPORT_INTERVAL > 0.f && memory_report_timer >= MEMORY_REPORT_INTERVAL) {
+                memory_report_timer = 0.f;
+                this->_device.memorySnapshot().print(std::cout);
+
+                auto arena = this->_renderer.get_frame_arena().get_stats();
+                std::cout << "  frame arena: " << arena.last_frame_used << " bytes last frame, peak "
+                    << arena.peak_used << " of " << this->_renderer.get_frame_arena().get_capacity()
+                    << ", " << arena.overflow_allocations << " heap fallback(s)" << std::endl;
+            }
         }
         vkDeviceWaitIdle(this->_device.device());
     }
@@ -130,15 +132,16 @@ namespace cge {
     void
     CGE_Engine::_load_game_objects() {
 
-        std::shared_ptr<CGE_Model> model 
-            = CGE_Model::create_model_from_file(_device, "models/colored_cube.obj");
+        // Models stream in on the loader's worker thread; the object draws its
+        // bounding box until the upload has completed
+        TransformComponent transform{};
+        transform.set_translation({0.0f, 0.0f, 2.5f});
+        // transform.set_scale({0.5f, 0.5f, 0.5f});
+        transform.set_scale(glm::vec3(0.5f)); 
 
-        auto game_object = CGE_Game_Object::_create_game_object();
-        game_object.model = model;
-        game_object.transform.translation = {0.0f, 0.0f, 2.5f};
-        // game_object.transform.scale = {0.5f, 0.5f, 0.5f};
-        game_object.transform.scale = glm::vec3(0.5f); 
+        ModelComponent model{};
+        model.pending_model = this->_model_loader.load_async("models/colored_cube.obj");
 
-        this->_game_objects.push_back(std::move(game_object));
+        this->_world.create(transform, std::move(model));
     }
 }
@@ -0,0 +1,108 @@
+#include "cge_frame_arena.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace cge {
+
+    // Huge pages are 2 MiB on x86-64 and most arm64 kernels
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    CGE_Frame_Arena::CGE_Frame_Arena(size_t capacity, uint32_t frame_count, bool huge_pages)
+        : _capacity{capacity}, _frame_count{frame_count}, _overflow(frame_count) {
+        assert(frame_count > 0 && "Frame arena needs at least one frame");
+
+#ifdef __linux__
+        // Map the partitions directly so they can be backed by transparent
+        // huge pages; madvise failing only means regular pages
+        if (huge_pages) {
+            _capacity = (capacity + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        }
+        _mapped_size = _capacity * frame_count;
+        void* memory = mmap(nullptr, _mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error("Error: failed to reserve frame arena");
+        }
+        _memory = static_cast<char*>(memory);
+        if (huge_pages) {
+            _huge_pages = madvise(memory, _mapped_size, MADV_HUGEPAGE) == 0;
+        }
+#else
+        (void)huge_pages;
+        _mapped_size = _capacity * frame_count;
+        _memory = static_cast<char*>(::operator new(_mapped_size));
+#endif
+
+        _begin = _memory;
+    }
+
+    CGE_Frame_Arena::~CGE_Frame_Arena() {
+        for (auto& frame : _overflow) {
+            for (void* block : frame) {
+                std::free(block);
+            }
+        }
+
+#ifdef __linux__
+        munmap(_memory, _mapped_size);
+#else
+        ::operator delete(_memory);
+#endif
+    }
+
+    void
+    CGE_Frame_Arena::begin_frame(uint32_t frame_index) {
+        assert(frame_index < _frame_count && "Frame index out of range");
+
+        _last_frame_used = _head + _overflow_bytes;
+        _peak_used = std::max(_peak_used, _last_frame_used);
+
+        for (void* block : _overflow[frame_index]) {
+            std::free(block);
+        }
+        _overflow[frame_index].clear();
+
+        _frame_index = frame_index;
+        _begin = _memory + frame_index * _capacity;
+        _head = 0;
+        _overflow_bytes = 0;
+    }
+
+    void*
+    CGE_Frame_Arena::allocate(size_t size, size_t alignment) {
+        size_t offset = (_head + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= _capacity) {
+            _head = offset + size;
+            return _begin + offset;
+        }
+
+        // Out of room this frame; correct but slow, and visible in the stats
+        size_t block_alignment = std::max(alignment, alignof(std::max_align_t));
+        size_t rounded = (std::max<size_t>(size, 1) + block_alignment - 1) & ~(block_alignment - 1);
+        void* block = std::aligned_alloc(block_alignment, rounded);
+        if (!block) {
+            throw std::bad_alloc();
+        }
+        _overflow[_frame_index].push_back(block);
+        _overflow_bytes += size;
+        return block;
+    }
+
+    CGE_Frame_Arena::Stats
+    CGE_Frame_Arena::get_stats() const {
+        Stats stats{};
+        stats.used = _head + _overflow_bytes;
+        stats.last_frame_used = _last_frame_used;
+        stats.peak_used = std::max(_peak_used, stats.used);
+        stats.overflow_allocations = static_cast<uint32_t>(_overflow[_frame_index].size());
+        stats.overflow_bytes = _overflow_bytes;
+        return stats;
+    }
+
+} // cge
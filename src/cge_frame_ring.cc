@@ -0,0 +1,96 @@
+#include "cge_frame_ring.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace cge {
+
+    // Vulkan alignments are powers of two
+    static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    CGE_Frame_Ring::CGE_Frame_Ring(
+        CGE_Device& device,
+        VkDeviceSize frame_size,
+        uint32_t frame_count,
+        VkBufferUsageFlags usage
+    ) : _frame_count{frame_count} {
+        const VkPhysicalDeviceLimits& limits = device.properties.limits;
+
+        // Slices start on the strictest offset alignment of the descriptor
+        // types they may back. Partitions also start and end on the non
+        // coherent atom, so flushing one frame's ranges never touches another
+        _atom_size = std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1);
+        _alignment = 16;
+        if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+            _alignment = std::max(_alignment, limits.minUniformBufferOffsetAlignment);
+        }
+        if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+            _alignment = std::max(_alignment, limits.minStorageBufferOffsetAlignment);
+        }
+        _frame_size = align_up(frame_size, std::max(_alignment, _atom_size));
+
+        // Read by the GPU every frame, so keep it in VRAM when the device
+        // exposes a large mappable window into it
+        VkMemoryPropertyFlags preferred = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        if (device.memoryAllocator().uses_direct_write()) {
+            preferred |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        }
+
+        _buffer = std::make_unique<CGE_Buffer>(
+            device,
+            _frame_size,
+            frame_count,
+            usage,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+            1,
+            preferred
+        );
+        if (_buffer->map() != VK_SUCCESS) {
+            throw std::runtime_error("Error: failed to map frame ring buffer");
+        }
+    }
+
+    void
+    CGE_Frame_Ring::begin_frame(uint32_t frame_index) {
+        assert(frame_index < _frame_count && "Frame index out of range");
+        _frame_begin = frame_index * _frame_size;
+        _head = _frame_begin;
+    }
+
+    CGE_Frame_Ring::Slice
+    CGE_Frame_Ring::allocate(VkDeviceSize size) {
+        Slice slice{};
+        VkDeviceSize offset = align_up(_head, _alignment);
+        if (size == 0 || offset + size > _frame_begin + _frame_size)
+            return slice;
+
+        _head = offset + size;
+        _peak_used = std::max(_peak_used, _head - _frame_begin);
+        _buffer->mark_dirty(size, offset);
+
+        slice.buffer = _buffer->get_buffer();
+        slice.offset = offset;
+        slice.size = size;
+        slice.data = static_cast<char*>(_buffer->get_mapped_memory()) + offset;
+        return slice;
+    }
+
+    CGE_Frame_Ring::Slice
+    CGE_Frame_Ring::write(const void* data, VkDeviceSize size) {
+        Slice slice = this->allocate(size);
+        if (slice.valid()) {
+            memcpy(slice.data, data, size);
+        }
+        return slice;
+    }
+
+    void
+    CGE_Frame_Ring::flush() {
+        _buffer->flush_dirty();
+    }
+
+} // cge
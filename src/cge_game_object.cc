@@ -1,16 +1,109 @@
 #include "cge_game_object.hh"
+#include "cge_transform_batch.hh"
 
 namespace cge {
 
-        glm::mat4 
-        TransformComponent::mat4() {
+        TransformComponent::TransformComponent(
+            const glm::vec3& translation,
+            const glm::vec3& scale,
+            const glm::vec3& rotation
+        ) : _translation{translation}, _scale{scale}, _rotation{rotation} {
+        }
+
+        void
+        TransformComponent::set_translation(const glm::vec3& translation) {
+            if (translation == _translation)
+                return;
+            _translation = translation;
+            _invalidate();
+        }
+
+        void
+        TransformComponent::set_scale(const glm::vec3& scale) {
+            if (scale == _scale)
+                return;
+            _scale = scale;
+            _invalidate();
+        }
+
+        void
+        TransformComponent::set_rotation(const glm::vec3& rotation) {
+            if (rotation == _rotation)
+                return;
+            _rotation = rotation;
+            _invalidate();
+        }
+
+        void
+        TransformComponent::_update_matrices() {
+            compose(_translation, _scale, _rotation, _matrix, _normal_matrix);
+            _dirty = false;
+        }
+
+        // Dirty transforms are gathered into structure of arrays batches on
+        // the stack, composed together and written back
+        void
+        TransformComponent::update_matrices(TransformComponent* transforms, uint32_t count) {
+            constexpr uint32_t BATCH = 64;
+            float values[9][BATCH];
+            glm::mat4 matrices[BATCH];
+            glm::mat3 normal_matrices[BATCH];
+            TransformComponent* batch[BATCH];
+
+            CGE_Transform_SoA soa{};
+            for (int axis = 0; axis < 3; axis++) {
+                soa.translation[axis] = values[axis];
+                soa.rotation[axis] = values[3 + axis];
+                soa.scale[axis] = values[6 + axis];
+            }
+
+            uint32_t batch_size = 0;
+            auto flush = [&]() {
+                cge_compose_transforms(soa, batch_size, matrices, normal_matrices);
+                for (uint32_t i = 0; i < batch_size; i++) {
+                    batch[i]->_matrix = matrices[i];
+                    batch[i]->_normal_matrix = normal_matrices[i];
+                    batch[i]->_dirty = false;
+                }
+                batch_size = 0;
+            };
+
+            for (uint32_t i = 0; i < count; i++) {
+                TransformComponent& transform = transforms[i];
+                if (!transform._dirty)
+                    continue;
+
+                for (int axis = 0; axis < 3; axis++) {
+                    values[axis][batch_size] = transform._translation[axis];
+                    values[3 + axis][batch_size] = transform._rotation[axis];
+                    values[6 + axis][batch_size] = transform._scale[axis];
+                }
+                batch[batch_size++] = &transform;
+                if (batch_size == BATCH) {
+                    flush();
+                }
+            }
+            if (batch_size > 0) {
+                flush();
+            }
+        }
+
+        // Both matrices share the same six sines and cosines
+        void
+        TransformComponent::compose(
+            const glm::vec3& translation,
+            const glm::vec3& scale,
+            const glm::vec3& rotation,
+            glm::mat4& matrix,
+            glm::mat3& normal_matrix
+        ) {
             const float c3 = glm::cos(rotation.z);
             const float s3 = glm::sin(rotation.z);
             const float c2 = glm::cos(rotation.x);
             const float s2 = glm::sin(rotation.x);
             const float c1 = glm::cos(rotation.y);
             const float s1 = glm::sin(rotation.y);
-            return glm::mat4{
+            matrix = glm::mat4{
                 {
                     scale.x * (c1 * c3 + s1 * s2 * s3),
                     scale.x * (c2 * s3),
@@ -36,19 +129,9 @@ namespace cge {
                     1.0f
                 }
             };
-        }
 
-
-        glm::mat3 
-        TransformComponent::normalMatrix() {
-            const float c3 = glm::cos(rotation.z);
-            const float s3 = glm::sin(rotation.z);
-            const float c2 = glm::cos(rotation.x);
-            const float s2 = glm::sin(rotation.x);
-            const float c1 = glm::cos(rotation.y);
-            const float s1 = glm::sin(rotation.y);
             const glm::vec3 invScale = 1.0f / scale;
-            return glm::mat3{
+            normal_matrix = glm::mat3{
                 {
                     invScale.x * (c1 * c3 + s1 * s2 * s3),
                     invScale.x * (c2 * s3),
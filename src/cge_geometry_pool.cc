@@ -0,0 +1,175 @@
+#include "cge_geometry_pool.hh"
+#include "cge_model.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace cge {
+
+    CGE_Range_Allocator::CGE_Range_Allocator(uint32_t capacity) : _capacity{capacity} {
+        if (capacity > 0) {
+            _free_ranges[0] = capacity;
+        }
+    }
+
+    uint32_t
+    CGE_Range_Allocator::allocate(uint32_t count) {
+        if (count == 0)
+            return INVALID;
+
+        for (auto it = _free_ranges.begin(); it != _free_ranges.end(); ++it) {
+            if (it->second < count)
+                continue;
+
+            uint32_t offset = it->first;
+            uint32_t remaining = it->second - count;
+            _free_ranges.erase(it);
+            if (remaining > 0) {
+                _free_ranges[offset + count] = remaining;
+            }
+
+            _allocations++;
+            return offset;
+        }
+        return INVALID;
+    }
+
+    void
+    CGE_Range_Allocator::free(uint32_t offset, uint32_t count) {
+        if (count == 0 || offset == INVALID)
+            return;
+
+        auto next = _free_ranges.lower_bound(offset);
+        assert((next == _free_ranges.end() || offset + count <= next->first) && "Range freed twice");
+
+        // Merge with the following range
+        if (next != _free_ranges.end() && offset + count == next->first) {
+            count += next->second;
+            next = _free_ranges.erase(next);
+        }
+
+        // Merge with the preceding range
+        if (next != _free_ranges.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset) {
+                previous->second += count;
+                count = 0;
+            }
+        }
+        if (count > 0) {
+            _free_ranges[offset] = count;
+        }
+
+        _allocations--;
+    }
+
+    CGE_Range_Allocator::Stats
+    CGE_Range_Allocator::get_stats() const {
+        Stats stats{};
+        stats.capacity = _capacity;
+        stats.allocations = _allocations;
+        stats.free_ranges = static_cast<uint32_t>(_free_ranges.size());
+
+        uint64_t free = 0;
+        for (const auto& range : _free_ranges) {
+            free += range.second;
+            stats.largest_free = std::max<uint64_t>(stats.largest_free, range.second);
+        }
+        stats.used = _capacity - free;
+        return stats;
+    }
+
+    CGE_Geometry_Pool::CGE_Geometry_Pool(
+        CGE_Device& device,
+        CGE_Vertex_Format vertex_format,
+        uint32_t vertex_capacity,
+        uint32_t index_capacity,
+        uint32_t frame_count
+    ) : _vertex_format{vertex_format}, _vertices{vertex_capacity}, _indices{index_capacity}, _retired(frame_count) {
+        _vertex_stride = vertex_format == CGE_Vertex_Format::FULL
+            ? sizeof(CGE_Model::Vertex)
+            : sizeof(CGE_Packed_Vertex);
+
+        VkMemoryPropertyFlags preferred = device.memoryAllocator().uses_direct_write()
+            ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            : 0;
+
+        _vertex_buffer = std::make_unique<CGE_Buffer>(
+            device,
+            _vertex_stride,
+            vertex_capacity,
+            CGE_Model::vertex_buffer_usage(device),
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            1,
+            preferred
+        );
+
+        _index_buffer = std::make_unique<CGE_Buffer>(
+            device,
+            sizeof(uint32_t),
+            index_capacity,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            1,
+            preferred
+        );
+    }
+
+    CGE_Geometry_Pool::Allocation
+    CGE_Geometry_Pool::allocate(uint32_t vertex_count, uint32_t index_count) {
+        Allocation allocation{};
+
+        uint32_t first_vertex = _vertices.allocate(vertex_count);
+        if (first_vertex == CGE_Range_Allocator::INVALID)
+            return allocation;
+
+        uint32_t first_index = 0;
+        if (index_count > 0) {
+            first_index = _indices.allocate(index_count);
+            if (first_index == CGE_Range_Allocator::INVALID) {
+                _vertices.free(first_vertex, vertex_count);
+                return allocation;
+            }
+        }
+
+        allocation.first_vertex = first_vertex;
+        allocation.vertex_count = vertex_count;
+        allocation.first_index = first_index;
+        allocation.index_count = index_count;
+        return allocation;
+    }
+
+    void
+    CGE_Geometry_Pool::free(const Allocation& allocation) {
+        if (!allocation.valid())
+            return;
+
+        _retired[_frame_index].push_back(allocation);
+    }
+
+    void
+    CGE_Geometry_Pool::begin_frame(uint32_t frame_index) {
+        assert(frame_index < _retired.size() && "Frame index out of range");
+        for (const Allocation& allocation : _retired[frame_index]) {
+            _vertices.free(allocation.first_vertex, allocation.vertex_count);
+            _indices.free(allocation.first_index, allocation.index_count);
+        }
+        _retired[frame_index].clear();
+        _frame_index = frame_index;
+    }
+
+    void
+    CGE_Geometry_Pool::_bind(VkCommandBuffer command_buffer) {
+        VkBuffer buffers[] = {_vertex_buffer->get_buffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
+        _bind_indices(command_buffer);
+    }
+
+    void
+    CGE_Geometry_Pool::_bind_indices(VkCommandBuffer command_buffer) {
+        vkCmdBindIndexBuffer(command_buffer, _index_buffer->get_buffer(), 0, VK_INDEX_TYPE_UINT32);
+    }
+
+} // cge
@@ -0,0 +1,112 @@
+#include "cge_growable_buffer.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace cge {
+
+    CGE_Growable_Buffer::CGE_Growable_Buffer(
+        CGE_Device& device,
+        VkDeviceSize element_size,
+        uint32_t initial_capacity,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags memory_property_flags,
+        uint32_t frame_count
+    ) : _device{device},
+        _element_size{element_size},
+        _usage{usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT},
+        _memory_property_flags{memory_property_flags},
+        _retired(frame_count)
+    {
+        _capacity = std::max<uint32_t>(initial_capacity, 1);
+        _buffer = this->_create_buffer(_capacity);
+    }
+
+    std::unique_ptr<CGE_Buffer>
+    CGE_Growable_Buffer::_create_buffer(uint32_t capacity) {
+        auto buffer = std::make_unique<CGE_Buffer>(
+            _device,
+            _element_size,
+            capacity,
+            _usage,
+            _memory_property_flags
+        );
+        if (buffer->is_host_visible()) {
+            buffer->map();
+        }
+        return buffer;
+    }
+
+    void
+    CGE_Growable_Buffer::begin_frame(uint32_t frame_index) {
+        assert(frame_index < _retired.size() && "Frame index out of range");
+        _retired[frame_index].clear();
+        _frame_index = frame_index;
+    }
+
+    bool
+    CGE_Growable_Buffer::reserve(VkCommandBuffer command_buffer, uint32_t count) {
+        if (count <= _capacity)
+            return false;
+
+        uint32_t capacity = std::max(count, static_cast<uint32_t>(_capacity * GROWTH_FACTOR));
+        auto buffer = this->_create_buffer(capacity);
+        VkDeviceSize used_bytes = _size * _element_size;
+
+        if (used_bytes > 0 && _buffer->is_host_visible()) {
+            // The latest contents were written through the old mapping, and
+            // later writes this frame go to the new one
+            std::memcpy(buffer->get_mapped_memory(), _buffer->get_mapped_memory(), used_bytes);
+            if (!(buffer->get_memory_property_flags() & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+                buffer->flush();
+            }
+        } else if (used_bytes > 0 && command_buffer == VK_NULL_HANDLE) {
+            _device.copyBuffer(_buffer->get_buffer(), buffer->get_buffer(), used_bytes);
+        } else if (used_bytes > 0) {
+            // Earlier GPU writes to the old buffer finish before the copy
+            // reads it, and the copy finishes before anything reads the new one
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr);
+
+            VkBufferCopy copy_region{};
+            copy_region.size = used_bytes;
+            vkCmdCopyBuffer(command_buffer, _buffer->get_buffer(), buffer->get_buffer(), 1, &copy_region);
+
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            vkCmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr);
+        }
+
+        _retired[_frame_index].push_back(std::move(_buffer));
+        _buffer = std::move(buffer);
+        _capacity = capacity;
+        _grow_count++;
+        return true;
+    }
+
+    bool
+    CGE_Growable_Buffer::resize(VkCommandBuffer command_buffer, uint32_t count) {
+        bool replaced = this->reserve(command_buffer, count);
+        _size = count;
+        return replaced;
+    }
+
+} // cge
@@ -0,0 +1,404 @@
+#include "cge_memory_allocator.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+
+namespace cge {
+
+    const char*
+    cge_memory_category_name(CGE_Memory_Category category) {
+        switch (category) {
+            case CGE_Memory_Category::GEOMETRY: return "geometry";
+            case CGE_Memory_Category::UNIFORM:  return "uniform";
+            case CGE_Memory_Category::STAGING:  return "staging";
+            case CGE_Memory_Category::DEPTH:    return "depth";
+            case CGE_Memory_Category::TEXTURE:  return "texture";
+            default:                            return "other";
+        }
+    }
+
+    // One vkAllocateMemory object split into power of two ranges.
+    // free_lists[k] holds the offsets of free ranges of MIN_ALLOCATION << k bytes
+    struct CGE_Memory_Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize size = 0;
+        uint32_t max_order = 0;
+        uint32_t live_allocations = 0;
+        bool linear = true;
+        std::vector<std::set<VkDeviceSize>> free_lists;
+    };
+
+    static VkDeviceSize order_size(uint32_t order) {
+        return CGE_Memory_Allocator::MIN_ALLOCATION << order;
+    }
+
+    // Smallest order whose range holds size bytes
+    static uint32_t order_for(VkDeviceSize size) {
+        uint32_t order = 0;
+        while (order_size(order) < size) {
+            order++;
+        }
+        return order;
+    }
+
+    CGE_Memory_Allocator::CGE_Memory_Allocator(VkPhysicalDevice physical_device, VkDevice device, bool device_address)
+        : _device{device}, _device_address{device_address} {
+        vkGetPhysicalDeviceMemoryProperties(physical_device, &_memory_properties);
+
+        _memory_types.resize(_memory_properties.memoryTypeCount);
+        for (uint32_t i = 0; i < _memory_properties.memoryTypeCount; i++) {
+            const VkMemoryType& type = _memory_properties.memoryTypes[i];
+            VkDeviceSize heap_size = _memory_properties.memoryHeaps[type.heapIndex].size;
+
+            // Keep blocks a power of two and small relative to their heap
+            VkDeviceSize block_size = BLOCK_SIZE;
+            while (block_size > MIN_ALLOCATION && block_size * 8 > heap_size) {
+                block_size /= 2;
+            }
+            _memory_types[i].block_size = block_size;
+            _memory_types[i].host_visible = (type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+        }
+
+        // Direct writes only pay off when the mappable device local memory is
+        // not a small window next to the real VRAM heap
+        VkDeviceSize largest_device_heap = 0;
+        for (uint32_t i = 0; i < _memory_properties.memoryHeapCount; i++) {
+            if (_memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                largest_device_heap = std::max(largest_device_heap, _memory_properties.memoryHeaps[i].size);
+            }
+        }
+        const VkMemoryPropertyFlags direct_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        for (uint32_t i = 0; i < _memory_properties.memoryTypeCount; i++) {
+            const VkMemoryType& type = _memory_properties.memoryTypes[i];
+            if ((type.propertyFlags & direct_flags) == direct_flags
+                && _memory_properties.memoryHeaps[type.heapIndex].size >= largest_device_heap) {
+                _direct_write = true;
+            }
+        }
+        _upload_stats.direct_write = _direct_write;
+    }
+
+    CGE_Memory_Allocator::~CGE_Memory_Allocator() {
+        // Anything still allocated here belongs to a buffer or image that was
+        // never destroyed
+        for (uint32_t i = 0; i < CGE_MEMORY_CATEGORY_COUNT; i++) {
+            if (_categories[i].allocation_count > 0) {
+                std::cerr << "Leaked " << _categories[i].allocation_count << " "
+                    << cge_memory_category_name(static_cast<CGE_Memory_Category>(i))
+                    << " allocation(s), " << _categories[i].bytes << " bytes" << std::endl;
+            }
+        }
+
+        for (auto& type : _memory_types) {
+            assert(type.allocation_count == 0 && "Device memory still allocated at shutdown");
+            for (auto& block : type.blocks) {
+                vkFreeMemory(_device, block->memory, nullptr);
+            }
+        }
+    }
+
+    static uint32_t count_bits(VkMemoryPropertyFlags flags) {
+        uint32_t count = 0;
+        for (; flags; flags &= flags - 1) {
+            count++;
+        }
+        return count;
+    }
+
+    uint32_t
+    CGE_Memory_Allocator::find_memory_type(
+        uint32_t type_bits,
+        VkMemoryPropertyFlags required,
+        VkMemoryPropertyFlags preferred
+    ) const {
+        uint32_t best = UINT32_MAX;
+        int best_score = 0;
+        VkDeviceSize best_heap = 0;
+
+        for (uint32_t i = 0; i < _memory_properties.memoryTypeCount; i++) {
+            VkMemoryPropertyFlags flags = _memory_properties.memoryTypes[i].propertyFlags;
+            if (!(type_bits & (1u << i)) || (flags & required) != required)
+                continue;
+
+            int score = 16 * static_cast<int>(count_bits(flags & preferred))
+                - static_cast<int>(count_bits(flags & ~(required | preferred)));
+            VkDeviceSize heap = _memory_properties.memoryHeaps[_memory_properties.memoryTypes[i].heapIndex].size;
+            if (best == UINT32_MAX || score > best_score || (score == best_score && heap > best_heap)) {
+                best = i;
+                best_score = score;
+                best_heap = heap;
+            }
+        }
+
+        if (best == UINT32_MAX) {
+            throw std::runtime_error("Error: failed to find suitable memory type");
+        }
+        return best;
+    }
+
+    VkDeviceMemory
+    CGE_Memory_Allocator::_allocate_memory(uint32_t memory_type, VkDeviceSize size, void** mapped) {
+        VkMemoryAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = size;
+        alloc_info.memoryTypeIndex = memory_type;
+
+        VkMemoryAllocateFlagsInfo flags_info{};
+        if (_device_address) {
+            flags_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+            flags_info.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
+            alloc_info.pNext = &flags_info;
+        }
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(_device, &alloc_info, nullptr, &memory) != VK_SUCCESS) {
+            throw std::runtime_error("Error: failed to allocate device memory");
+        }
+
+        *mapped = nullptr;
+        if (_memory_types[memory_type].host_visible
+            && vkMapMemory(_device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+            vkFreeMemory(_device, memory, nullptr);
+            throw std::runtime_error("Error: failed to map device memory");
+        }
+        return memory;
+    }
+
+    CGE_Memory_Block*
+    CGE_Memory_Allocator::_create_block(uint32_t memory_type, bool linear) {
+        Memory_Type& type = _memory_types[memory_type];
+
+        auto block = std::make_unique<CGE_Memory_Block>();
+        block->size = type.block_size;
+        block->linear = linear;
+        block->max_order = order_for(block->size);
+        block->free_lists.resize(block->max_order + 1);
+        block->free_lists[block->max_order].insert(0);
+        block->memory = this->_allocate_memory(memory_type, block->size, &block->mapped);
+
+        type.blocks.push_back(std::move(block));
+        return type.blocks.back().get();
+    }
+
+    CGE_Allocation
+    CGE_Memory_Allocator::allocate(
+        const VkMemoryRequirements& requirements,
+        uint32_t memory_type,
+        bool linear,
+        CGE_Memory_Category category
+    ) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Memory_Type& type = _memory_types[memory_type];
+
+        CGE_Allocation allocation{};
+        allocation.size = requirements.size;
+        allocation.memory_type = memory_type;
+        allocation.category = category;
+
+        Category_Stats& category_stats = _categories[static_cast<uint32_t>(category)];
+        category_stats.allocation_count++;
+        category_stats.bytes += requirements.size;
+        category_stats.peak_bytes = std::max(category_stats.peak_bytes, category_stats.bytes);
+
+        // Large resources would waste most of a block to rounding, give them
+        // their own memory object
+        VkDeviceSize needed = std::max({requirements.size, requirements.alignment, MIN_ALLOCATION});
+        if (needed > type.block_size / 4) {
+            allocation.memory = this->_allocate_memory(memory_type, requirements.size, &allocation.mapped);
+            allocation.allocated_size = requirements.size;
+
+            type.allocation_count++;
+            type.dedicated_count++;
+            type.dedicated_bytes += requirements.size;
+            type.used_bytes += requirements.size;
+            return allocation;
+        }
+
+        uint32_t order = order_for(needed);
+
+        // Smallest free range of at least that order in a block of the same kind
+        CGE_Memory_Block* block = nullptr;
+        uint32_t found = 0;
+        for (auto& candidate : type.blocks) {
+            if (candidate->linear != linear)
+                continue;
+            for (uint32_t k = order; k <= candidate->max_order; k++) {
+                if (!candidate->free_lists[k].empty() && (!block || k < found)) {
+                    block = candidate.get();
+                    found = k;
+                    break;
+                }
+            }
+            if (block && found == order)
+                break;
+        }
+        if (!block) {
+            block = this->_create_block(memory_type, linear);
+            found = block->max_order;
+        }
+
+        VkDeviceSize offset = *block->free_lists[found].begin();
+        block->free_lists[found].erase(block->free_lists[found].begin());
+
+        // Split down to the requested order, keeping the upper halves free
+        while (found > order) {
+            found--;
+            block->free_lists[found].insert(offset + order_size(found));
+        }
+
+        block->live_allocations++;
+        allocation.memory = block->memory;
+        allocation.offset = offset;
+        allocation.allocated_size = order_size(order);
+        allocation.mapped = block->mapped ? static_cast<char*>(block->mapped) + offset : nullptr;
+        allocation.block = block;
+        allocation.order = order;
+
+        type.allocation_count++;
+        type.used_bytes += requirements.size;
+        type.wasted_bytes += allocation.allocated_size - requirements.size;
+        return allocation;
+    }
+
+    void
+    CGE_Memory_Allocator::free(const CGE_Allocation& allocation) {
+        if (allocation.memory == VK_NULL_HANDLE)
+            return;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        Memory_Type& type = _memory_types[allocation.memory_type];
+        type.allocation_count--;
+        type.used_bytes -= allocation.size;
+
+        Category_Stats& category_stats = _categories[static_cast<uint32_t>(allocation.category)];
+        category_stats.allocation_count--;
+        category_stats.bytes -= allocation.size;
+
+        if (!allocation.block) {
+            vkFreeMemory(_device, allocation.memory, nullptr);
+            type.dedicated_count--;
+            type.dedicated_bytes -= allocation.size;
+            return;
+        }
+
+        type.wasted_bytes -= allocation.allocated_size - allocation.size;
+
+        // Merge with the buddy for as long as it is free too
+        CGE_Memory_Block* block = allocation.block;
+        VkDeviceSize offset = allocation.offset;
+        uint32_t order = allocation.order;
+        while (order < block->max_order) {
+            VkDeviceSize buddy = offset ^ order_size(order);
+            auto it = block->free_lists[order].find(buddy);
+            if (it == block->free_lists[order].end())
+                break;
+
+            block->free_lists[order].erase(it);
+            offset = std::min(offset, buddy);
+            order++;
+        }
+        block->free_lists[order].insert(offset);
+        block->live_allocations--;
+
+        // Release empty blocks, but keep one per kind around to avoid
+        // reallocating on every load and unload
+        if (block->live_allocations > 0)
+            return;
+
+        auto same_kind = std::count_if(type.blocks.begin(), type.blocks.end(), [&](const auto& b) {
+            return b->linear == block->linear;
+        });
+        if (same_kind <= 1)
+            return;
+
+        vkFreeMemory(_device, block->memory, nullptr);
+        type.blocks.erase(std::find_if(type.blocks.begin(), type.blocks.end(), [&](const auto& b) {
+            return b.get() == block;
+        }));
+    }
+
+    void
+    CGE_Memory_Allocator::record_upload(VkDeviceSize bytes, bool direct) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (direct) {
+            _upload_stats.direct_uploads++;
+            _upload_stats.direct_bytes += bytes;
+        } else {
+            _upload_stats.staged_uploads++;
+            _upload_stats.staged_bytes += bytes;
+        }
+    }
+
+    CGE_Memory_Allocator::Upload_Stats
+    CGE_Memory_Allocator::get_upload_stats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _upload_stats;
+    }
+
+    std::array<CGE_Memory_Allocator::Category_Stats, CGE_MEMORY_CATEGORY_COUNT>
+    CGE_Memory_Allocator::get_category_stats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _categories;
+    }
+
+    std::vector<CGE_Memory_Allocator::Heap_Stats>
+    CGE_Memory_Allocator::get_heap_stats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::vector<Heap_Stats> heaps(_memory_properties.memoryHeapCount);
+        for (uint32_t i = 0; i < _memory_types.size(); i++) {
+            const Memory_Type& type = _memory_types[i];
+            Heap_Stats& heap = heaps[_memory_properties.memoryTypes[i].heapIndex];
+
+            heap.allocation_count += type.allocation_count;
+            heap.device_allocations += static_cast<uint32_t>(type.blocks.size()) + type.dedicated_count;
+            heap.allocated_bytes += type.blocks.size() * type.block_size + type.dedicated_bytes;
+            heap.used_bytes += type.used_bytes;
+            heap.wasted_bytes += type.wasted_bytes;
+        }
+        return heaps;
+    }
+
+    static double to_mib(VkDeviceSize bytes) {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+
+    void
+    CGE_Memory_Snapshot::print(std::ostream& out) const {
+        auto flags = out.flags();
+        auto precision = out.precision();
+        out << std::fixed << std::setprecision(1);
+
+        out << "GPU memory" << (budget_available ? "" : " (no VK_EXT_memory_budget)") << ":\n";
+        for (size_t i = 0; i < heaps.size(); i++) {
+            const Heap& heap = heaps[i];
+            out << "  heap " << i << (heap.device_local ? " device" : " host  ")
+                << "  usage " << to_mib(heap.usage) << " / " << to_mib(heap.budget) << " MiB budget"
+                << " (" << to_mib(heap.size) << " MiB heap)"
+                << "  engine " << to_mib(heap.engine.allocated_bytes) << " MiB in "
+                << heap.engine.device_allocations << " allocation(s), "
+                << heap.engine.allocation_count << " resource(s), "
+                << to_mib(heap.engine.wasted_bytes) << " MiB rounding\n";
+        }
+        for (uint32_t i = 0; i < CGE_MEMORY_CATEGORY_COUNT; i++) {
+            const auto& category = categories[i];
+            out << "  " << std::left << std::setw(9) << cge_memory_category_name(static_cast<CGE_Memory_Category>(i))
+                << std::right << to_mib(category.bytes) << " MiB in " << category.allocation_count
+                << " resource(s), peak " << to_mib(category.peak_bytes) << " MiB\n";
+        }
+        out << "  uploads: " << (uploads.direct_write ? "direct write" : "staged")
+            << ", " << uploads.direct_uploads << " direct (" << to_mib(uploads.direct_bytes) << " MiB)"
+            << ", " << uploads.staged_uploads << " staged (" << to_mib(uploads.staged_bytes) << " MiB)" << std::endl;
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+} // cge
@@ -0,0 +1,272 @@
+#include "cge_mesh_cache.hh"
+#include "utils.hh"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+namespace cge {
+
+    namespace fs = std::filesystem;
+
+    static constexpr char CACHE_MAGIC[4] = {'C', 'G', 'E', 'M'};
+
+    // Round a payload offset up so each array starts 16 byte aligned
+    static uint64_t align_offset(uint64_t offset) {
+        return (offset + 15) & ~static_cast<uint64_t>(15);
+    }
+
+    // count elements of T at offset lie inside a file of size bytes and are
+    // aligned for T. Written so corrupt offsets cannot wrap around
+    template<typename T>
+    static bool array_fits(uint64_t offset, uint64_t count, size_t size) {
+        return offset % alignof(T) == 0
+            && offset <= size
+            && count * sizeof(T) <= size - offset;
+    }
+
+    // [first, first + count) lies inside [0, total)
+    static bool range_fits(uint64_t first, uint64_t count, uint64_t total) {
+        return first <= total && count <= total - first;
+    }
+
+    // Every index and every LOD and meshlet range points inside the arrays,
+    // so a damaged cache is a miss instead of an out of bounds read
+    static bool payload_in_range(const CGE_Mesh_Cache::Mapped_Mesh& mesh) {
+        const uint32_t* indices = mesh.indices();
+        for (uint32_t i = 0; i < mesh.index_count(); i++) {
+            if (indices[i] >= mesh.vertex_count())
+                return false;
+        }
+
+        const CGE_Meshlet* meshlets = mesh.meshlets();
+        for (uint32_t i = 0; i < mesh.meshlet_count(); i++) {
+            if (!range_fits(meshlets[i].first_index, uint64_t{meshlets[i].triangle_count} * 3, mesh.index_count()))
+                return false;
+        }
+
+        const CGE_Model::Lod* lods = mesh.lods();
+        for (uint32_t i = 0; i < mesh.lod_count(); i++) {
+            if (!range_fits(lods[i].first_index, lods[i].index_count, mesh.index_count())
+                || !range_fits(lods[i].first_meshlet, lods[i].meshlet_count, mesh.meshlet_count()))
+                return false;
+        }
+        return true;
+    }
+
+    // Stat the source file the way the cache keys it
+    static bool source_stamp(const std::string& source_path, int64_t& mtime, uint64_t& size) {
+        std::error_code ec;
+        auto write_time = fs::last_write_time(source_path, ec);
+        if (ec) return false;
+        auto file_size = fs::file_size(source_path, ec);
+        if (ec) return false;
+
+        mtime = static_cast<int64_t>(write_time.time_since_epoch().count());
+        size = static_cast<uint64_t>(file_size);
+        return true;
+    }
+
+    CGE_Mesh_Cache::Mapped_Mesh::Mapped_Mesh(void* data, size_t size) : _data{data}, _size{size} {}
+
+    CGE_Mesh_Cache::Mapped_Mesh::~Mapped_Mesh() {
+        if (_data) {
+            munmap(_data, _size);
+        }
+    }
+
+    CGE_Model::Mesh_View
+    CGE_Mesh_Cache::Mapped_Mesh::view() const {
+        CGE_Model::Mesh_View mesh{};
+        mesh.vertices = vertices();
+        mesh.vertex_count = vertex_count();
+        mesh.indices = indices();
+        mesh.index_count = index_count();
+        mesh.meshlets = meshlets();
+        mesh.meshlet_count = meshlet_count();
+        mesh.lods = lods();
+        mesh.lod_count = lod_count();
+        return mesh;
+    }
+
+    std::string
+    CGE_Mesh_Cache::cache_path(const std::string& source_path) {
+        return fs::path(source_path).replace_extension(".cgemesh").string();
+    }
+
+    // Hash the full contents of a file through a read-only mapping
+    bool
+    CGE_Mesh_Cache::_hash_file(const std::string& path, uint64_t& hash) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+
+        size_t size = static_cast<size_t>(st.st_size);
+        if (size == 0) {
+            close(fd);
+            hash = hash_bytes(nullptr, 0);
+            return true;
+        }
+
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return false;
+
+        madvise(data, size, MADV_SEQUENTIAL);
+        hash = hash_bytes(data, size);
+        munmap(data, size);
+        return true;
+    }
+
+    std::unique_ptr<CGE_Mesh_Cache::Mapped_Mesh>
+    CGE_Mesh_Cache::load(const std::string& source_path, uint64_t options_key) {
+        int64_t source_mtime;
+        uint64_t source_size;
+        if (!source_stamp(source_path, source_mtime, source_size)) {
+            return nullptr;
+        }
+
+        std::string path = cache_path(source_path);
+
+        // Read-write only so a stale mtime can be refreshed in place;
+        // a read-only cache is still usable
+        bool writable = true;
+        int fd = open(path.c_str(), O_RDWR);
+        if (fd < 0) {
+            writable = false;
+            fd = open(path.c_str(), O_RDONLY);
+        }
+        if (fd < 0) return nullptr;
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CGE_Mesh_Cache_Header)) {
+            close(fd);
+            return nullptr;
+        }
+
+        size_t size = static_cast<size_t>(st.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+
+        auto mesh = std::make_unique<Mapped_Mesh>(data, size);
+        const CGE_Mesh_Cache_Header& header = mesh->header();
+
+        bool valid = std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0
+                     && header.version == VERSION
+                     && header.vertex_size == sizeof(CGE_Model::Vertex)
+                     && header.options_key == options_key
+                     && header.meshlet_size == sizeof(CGE_Meshlet)
+                     && array_fits<CGE_Model::Vertex>(header.vertex_offset, header.vertex_count, size)
+                     && array_fits<uint32_t>(header.index_offset, header.index_count, size)
+                     && array_fits<CGE_Meshlet>(header.meshlet_offset, header.meshlet_count, size)
+                     && array_fits<CGE_Model::Lod>(header.lod_offset, header.lod_count, size)
+                     && header.source_size == source_size
+                     && payload_in_range(*mesh);
+
+        if (!valid) {
+            close(fd);
+            return nullptr;
+        }
+
+        // Same size but touched since the cache was written: only trust the
+        // cache if the contents hash the same, then refresh the stored stamp
+        // so the next launch takes the fast path again
+        if (header.source_mtime != source_mtime) {
+            uint64_t source_hash;
+            if (!_hash_file(source_path, source_hash) || source_hash != header.source_hash) {
+                close(fd);
+                return nullptr;
+            }
+
+            if (writable) {
+                ssize_t written = pwrite(fd, &source_mtime, sizeof(source_mtime),
+                                         offsetof(CGE_Mesh_Cache_Header, source_mtime));
+                (void)written;
+            }
+        }
+
+        close(fd);
+        madvise(data, size, MADV_WILLNEED);
+        return mesh;
+    }
+
+    bool
+    CGE_Mesh_Cache::store(const std::string& source_path, const CGE_Model::Builder& builder) {
+        CGE_Mesh_Cache_Header header{};
+        std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.version = VERSION;
+        header.vertex_size = sizeof(CGE_Model::Vertex);
+        header.vertex_count = static_cast<uint32_t>(builder.vertices.size());
+        header.index_count = static_cast<uint32_t>(builder.indices.size());
+        header.options_key = builder.cache_key();
+        header.lod_count = static_cast<uint32_t>(builder.lods.size());
+        header.meshlet_size = sizeof(CGE_Meshlet);
+        header.meshlet_count = static_cast<uint32_t>(builder.meshlets.size());
+
+        if (!source_stamp(source_path, header.source_mtime, header.source_size)
+            || !_hash_file(source_path, header.source_hash)) {
+            return false;
+        }
+
+        uint64_t vertex_bytes = static_cast<uint64_t>(header.vertex_count) * sizeof(CGE_Model::Vertex);
+        uint64_t index_bytes = static_cast<uint64_t>(header.index_count) * sizeof(uint32_t);
+        header.vertex_offset = align_offset(sizeof(CGE_Mesh_Cache_Header));
+        uint64_t meshlet_bytes = static_cast<uint64_t>(header.meshlet_count) * sizeof(CGE_Meshlet);
+        header.index_offset = align_offset(header.vertex_offset + vertex_bytes);
+        header.meshlet_offset = align_offset(header.index_offset + index_bytes);
+        uint64_t lod_bytes = static_cast<uint64_t>(header.lod_count) * sizeof(CGE_Model::Lod);
+        header.lod_offset = align_offset(header.meshlet_offset + meshlet_bytes);
+
+        // Write to a temporary file and rename over the old cache so a crash
+        // mid-write never leaves a truncated file behind
+        std::string path = cache_path(source_path);
+        std::string tmp_path = path + ".tmp";
+        {
+            std::ofstream file{tmp_path, std::ios::binary | std::ios::trunc};
+            if (!file.is_open()) {
+                return false;
+            }
+
+            static const char padding[16] = {};
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(padding, header.vertex_offset - sizeof(header));
+            file.write(reinterpret_cast<const char*>(builder.vertices.data()), vertex_bytes);
+            file.write(padding, header.index_offset - (header.vertex_offset + vertex_bytes));
+            file.write(reinterpret_cast<const char*>(builder.indices.data()), index_bytes);
+            file.write(padding, header.meshlet_offset - (header.index_offset + index_bytes));
+            file.write(reinterpret_cast<const char*>(builder.meshlets.data()), meshlet_bytes);
+            file.write(padding, header.lod_offset - (header.meshlet_offset + meshlet_bytes));
+            file.write(reinterpret_cast<const char*>(builder.lods.data()), lod_bytes);
+
+            if (!file) {
+                file.close();
+                std::remove(tmp_path.c_str());
+                return false;
+            }
+        }
+
+        if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+} // cge
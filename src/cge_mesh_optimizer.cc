@@ -0,0 +1,357 @@
+#include "cge_mesh_optimizer.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace cge {
+
+namespace {
+
+    // FIFO post-transform cache simulated with per-vertex timestamps.
+    // A vertex is resident while fewer than cache_size misses happened
+    // since it was loaded, so a flush is just bumping the clock
+    class Fifo_Cache {
+        public:
+            Fifo_Cache(size_t vertex_count, uint32_t cache_size)
+                : _timestamps(vertex_count, 0), _cache_size{cache_size}, _time{cache_size + 1} {}
+
+            // Returns 1 if vertex had to be transformed
+            uint32_t access(uint32_t vertex) {
+                if (_time - _timestamps[vertex] > _cache_size) {
+                    _timestamps[vertex] = _time++;
+                    return 1;
+                }
+                return 0;
+            }
+
+            void flush() { _time += _cache_size + 1; }
+
+        private:
+            std::vector<uint32_t> _timestamps;
+            uint32_t _cache_size;
+            uint32_t _time;
+    };
+
+} // anonymous
+
+    static void validate_indices(const std::vector<uint32_t>& indices, size_t vertex_count) {
+        if (indices.size() % 3 != 0) {
+            throw std::runtime_error("mesh optimizer: index count is not a multiple of 3");
+        }
+        for (uint32_t index : indices) {
+            if (index >= vertex_count) {
+                throw std::runtime_error("mesh optimizer: index out of range");
+            }
+        }
+    }
+
+    CGE_Vertex_Cache_Stats
+    CGE_Mesh_Optimizer::analyze_vertex_cache(
+        const std::vector<uint32_t>& indices,
+        size_t vertex_count,
+        uint32_t cache_size
+    ) {
+        CGE_Vertex_Cache_Stats stats{};
+        stats.triangles = static_cast<uint32_t>(indices.size() / 3);
+        if (stats.triangles == 0) {
+            return stats;
+        }
+
+        Fifo_Cache cache{vertex_count, cache_size};
+        std::vector<bool> used(vertex_count, false);
+        uint32_t unique_vertices = 0;
+
+        for (uint32_t index : indices) {
+            stats.vertices_transformed += cache.access(index);
+            if (!used[index]) {
+                used[index] = true;
+                unique_vertices++;
+            }
+        }
+
+        stats.acmr = static_cast<float>(stats.vertices_transformed) / stats.triangles;
+        stats.atvr = static_cast<float>(stats.vertices_transformed) / unique_vertices;
+        return stats;
+    }
+
+    void
+    CGE_Mesh_Optimizer::optimize_vertex_cache(
+        std::vector<uint32_t>& indices,
+        size_t vertex_count,
+        std::vector<uint32_t>* clusters,
+        uint32_t cache_size
+    ) {
+        validate_indices(indices, vertex_count);
+
+        size_t triangle_count = indices.size() / 3;
+        if (clusters) {
+            clusters->clear();
+        }
+        if (triangle_count == 0) {
+            return;
+        }
+
+        // Vertex -> triangle adjacency, stored as offsets into one flat array
+        std::vector<uint32_t> live(vertex_count, 0);
+        for (uint32_t index : indices) {
+            live[index]++;
+        }
+
+        std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+        for (size_t v = 0; v < vertex_count; v++) {
+            adjacency_offsets[v + 1] = adjacency_offsets[v] + live[v];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); i++) {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<uint32_t> cache_time(vertex_count, 0);
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<uint32_t> dead_end;
+        std::vector<uint32_t> candidates;
+        dead_end.reserve(indices.size());
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        uint32_t timestamp = cache_size + 1;
+        size_t cursor = 0;
+        int64_t fanning = 0;
+        bool flushed = true;
+
+        while (fanning >= 0) {
+            uint32_t emitted_count = static_cast<uint32_t>(result.size() / 3);
+            if (flushed && clusters && (clusters->empty() || clusters->back() != emitted_count)) {
+                clusters->push_back(emitted_count);
+            }
+
+            // Emit every remaining triangle around the fanning vertex
+            candidates.clear();
+            uint32_t f = static_cast<uint32_t>(fanning);
+            for (uint32_t a = adjacency_offsets[f]; a < adjacency_offsets[f + 1]; a++) {
+                uint32_t triangle = adjacency[a];
+                if (emitted[triangle]) continue;
+
+                for (int k = 0; k < 3; k++) {
+                    uint32_t v = indices[3 * triangle + k];
+                    result.push_back(v);
+                    dead_end.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if (timestamp - cache_time[v] > cache_size) {
+                        cache_time[v] = timestamp++;
+                    }
+                }
+                emitted[triangle] = true;
+            }
+
+            // Prefer the candidate that will still be in the cache once all of
+            // its own triangles are emitted, and of those the oldest one
+            fanning = -1;
+            int64_t best_priority = -1;
+            for (uint32_t v : candidates) {
+                if (live[v] == 0) continue;
+
+                int64_t priority = 0;
+                if (timestamp - cache_time[v] + 2 * live[v] <= cache_size) {
+                    priority = timestamp - cache_time[v];
+                }
+                if (priority > best_priority) {
+                    best_priority = priority;
+                    fanning = v;
+                }
+            }
+
+            flushed = fanning < 0;
+            if (!flushed) continue;
+
+            // Dead end: restart from a recently used vertex if one still has
+            // triangles, otherwise from the next unfinished vertex in input order
+            while (!dead_end.empty()) {
+                uint32_t v = dead_end.back();
+                dead_end.pop_back();
+                if (live[v] > 0) {
+                    fanning = v;
+                    break;
+                }
+            }
+            while (fanning < 0 && cursor < vertex_count) {
+                if (live[cursor] > 0) {
+                    fanning = static_cast<int64_t>(cursor);
+                }
+                cursor++;
+            }
+        }
+
+        indices.swap(result);
+    }
+
+    void
+    CGE_Mesh_Optimizer::optimize_overdraw(
+        std::vector<uint32_t>& indices,
+        const std::vector<CGE_Model::Vertex>& vertices,
+        const std::vector<uint32_t>& clusters,
+        float threshold,
+        uint32_t cache_size
+    ) {
+        validate_indices(indices, vertices.size());
+
+        uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+        if (triangle_count == 0 || clusters.empty()) {
+            return;
+        }
+
+        // Split the hard clusters further wherever the triangles so far already
+        // reach an ACMR close to the whole cluster's; cutting there costs at most
+        // one cache refill and gives the sort more freedom
+        std::vector<uint32_t> boundaries;
+        Fifo_Cache cache{vertices.size(), cache_size};
+
+        for (size_t c = 0; c < clusters.size(); c++) {
+            uint32_t begin = clusters[c];
+            uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangle_count;
+            if (end <= begin) continue;
+
+            cache.flush();
+            uint32_t cluster_misses = 0;
+            for (uint32_t t = begin; t < end; t++) {
+                for (int k = 0; k < 3; k++) {
+                    cluster_misses += cache.access(indices[3 * t + k]);
+                }
+            }
+            float cluster_acmr = static_cast<float>(cluster_misses) / (end - begin);
+
+            cache.flush();
+            boundaries.push_back(begin);
+            uint32_t start = begin;
+            uint32_t misses = 0;
+            for (uint32_t t = begin; t < end; t++) {
+                for (int k = 0; k < 3; k++) {
+                    misses += cache.access(indices[3 * t + k]);
+                }
+
+                float running_acmr = static_cast<float>(misses) / (t - start + 1);
+                if (t + 1 < end && running_acmr <= cluster_acmr * threshold) {
+                    boundaries.push_back(t + 1);
+                    start = t + 1;
+                    misses = 0;
+                    cache.flush();
+                }
+            }
+        }
+
+        // Area weighted mesh centroid
+        glm::vec3 mesh_centroid{0.f};
+        float mesh_area = 0.f;
+        for (uint32_t t = 0; t < triangle_count; t++) {
+            const glm::vec3& p0 = vertices[indices[3 * t + 0]].position;
+            const glm::vec3& p1 = vertices[indices[3 * t + 1]].position;
+            const glm::vec3& p2 = vertices[indices[3 * t + 2]].position;
+            float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+            mesh_centroid += (p0 + p1 + p2) * (area / 3.f);
+            mesh_area += area;
+        }
+        if (mesh_area > 0.f) {
+            mesh_centroid /= mesh_area;
+        }
+
+        // Clusters that sit far out along their own normal are likely to
+        // occlude the rest of the mesh, so they are drawn first
+        struct Cluster {
+            uint32_t begin;
+            uint32_t end;
+            float sort_key;
+        };
+        std::vector<Cluster> sorted;
+        sorted.reserve(boundaries.size());
+
+        for (size_t c = 0; c < boundaries.size(); c++) {
+            uint32_t begin = boundaries[c];
+            uint32_t end = c + 1 < boundaries.size() ? boundaries[c + 1] : triangle_count;
+
+            glm::vec3 centroid{0.f};
+            glm::vec3 normal{0.f};
+            float area_sum = 0.f;
+            for (uint32_t t = begin; t < end; t++) {
+                const glm::vec3& p0 = vertices[indices[3 * t + 0]].position;
+                const glm::vec3& p1 = vertices[indices[3 * t + 1]].position;
+                const glm::vec3& p2 = vertices[indices[3 * t + 2]].position;
+                glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                float area = glm::length(n);
+                centroid += (p0 + p1 + p2) * (area / 3.f);
+                normal += n;
+                area_sum += area;
+            }
+
+            float sort_key = 0.f;
+            float normal_length = glm::length(normal);
+            if (area_sum > 0.f && normal_length > 0.f) {
+                centroid /= area_sum;
+                sort_key = glm::dot(centroid - mesh_centroid, normal / normal_length);
+            }
+            sorted.push_back({begin, end, sort_key});
+        }
+
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+            return a.sort_key > b.sort_key;
+        });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (const Cluster& cluster : sorted) {
+            result.insert(result.end(), indices.begin() + 3 * cluster.begin, indices.begin() + 3 * cluster.end);
+        }
+        indices.swap(result);
+    }
+
+    void
+    CGE_Mesh_Optimizer::optimize_vertex_fetch(
+        std::vector<CGE_Model::Vertex>& vertices,
+        std::vector<uint32_t>& indices
+    ) {
+        validate_indices(indices, vertices.size());
+
+        constexpr uint32_t UNUSED = 0xFFFFFFFFu;
+        std::vector<uint32_t> remap(vertices.size(), UNUSED);
+        std::vector<CGE_Model::Vertex> result;
+        result.reserve(vertices.size());
+
+        // Vertices no index refers to are dropped
+        for (uint32_t& index : indices) {
+            if (remap[index] == UNUSED) {
+                remap[index] = static_cast<uint32_t>(result.size());
+                result.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        vertices.swap(result);
+    }
+
+    void
+    CGE_Mesh_Optimizer::optimize(
+        CGE_Model::Builder& builder,
+        CGE_Vertex_Cache_Stats* before,
+        CGE_Vertex_Cache_Stats* after
+    ) {
+        if (before) {
+            *before = analyze_vertex_cache(builder.indices, builder.vertices.size());
+        }
+
+        std::vector<uint32_t> clusters;
+        optimize_vertex_cache(builder.indices, builder.vertices.size(), &clusters);
+        optimize_overdraw(builder.indices, builder.vertices, clusters);
+        optimize_vertex_fetch(builder.vertices, builder.indices);
+
+        if (after) {
+            *after = analyze_vertex_cache(builder.indices, builder.vertices.size());
+        }
+    }
+
+} // cge
@@ -0,0 +1,338 @@
+#include "cge_mesh_simplifier.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace cge {
+
+namespace {
+
+    // Weight of the planes added along open borders relative to face planes.
+    // Higher values keep outlines and holes intact for longer
+    constexpr double BORDER_WEIGHT = 10.0;
+
+    enum Vertex_Kind : uint8_t {
+        KIND_MANIFOLD,  // interior vertex, can collapse along any edge
+        KIND_BORDER,    // on an open border, can only collapse along it
+        KIND_LOCKED,    // seam or non-manifold, never moves
+    };
+
+    // Symmetric 4x4 quadric p^T A p + 2 b.p + c, plus the accumulated weight
+    // so the error can be reported as a mean squared distance
+    struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double weight = 0;
+
+        static Quadric from_plane(const glm::vec3& plane_normal, double d, double weight) {
+            double nx = plane_normal.x, ny = plane_normal.y, nz = plane_normal.z;
+            Quadric q;
+            q.a00 = nx * nx * weight; q.a01 = nx * ny * weight; q.a02 = nx * nz * weight;
+            q.a11 = ny * ny * weight; q.a12 = ny * nz * weight; q.a22 = nz * nz * weight;
+            q.b0 = nx * d * weight; q.b1 = ny * d * weight; q.b2 = nz * d * weight;
+            q.c = d * d * weight;
+            q.weight = weight;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& o) {
+            a00 += o.a00; a01 += o.a01; a02 += o.a02;
+            a11 += o.a11; a12 += o.a12; a22 += o.a22;
+            b0 += o.b0; b1 += o.b1; b2 += o.b2;
+            c += o.c;
+            weight += o.weight;
+            return *this;
+        }
+
+        double evaluate(const glm::vec3& v) const {
+            double x = v.x, y = v.y, z = v.z;
+            double r = a00 * x * x + a11 * y * y + a22 * z * z
+                     + 2 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                     + 2 * (b0 * x + b1 * y + b2 * z)
+                     + c;
+            return std::fabs(r);
+        }
+    };
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    uint64_t edge_key(uint32_t a, uint32_t b) {
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+
+} // anonymous
+
+    float
+    CGE_Mesh_Simplifier::error_scale(const std::vector<CGE_Model::Vertex>& vertices) {
+        if (vertices.empty()) return 1.f;
+
+        glm::vec3 bounds_min = vertices[0].position;
+        glm::vec3 bounds_max = vertices[0].position;
+        for (const auto& vertex : vertices) {
+            bounds_min = glm::min(bounds_min, vertex.position);
+            bounds_max = glm::max(bounds_max, vertex.position);
+        }
+
+        glm::vec3 size = bounds_max - bounds_min;
+        float extent = std::max(size.x, std::max(size.y, size.z));
+        return extent > 0.f ? extent : 1.f;
+    }
+
+    std::vector<uint32_t>
+    CGE_Mesh_Simplifier::simplify(
+        const std::vector<CGE_Model::Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        size_t target_index_count,
+        float target_error,
+        float* result_error
+    ) {
+        std::vector<uint32_t> result = indices;
+        if (result_error) *result_error = 0.f;
+
+        size_t vertex_count = vertices.size();
+        if (result.size() <= target_index_count || vertex_count == 0) {
+            return result;
+        }
+
+        // Work in a unit sized box so errors are relative to the mesh
+        glm::vec3 origin = vertices[0].position;
+        for (const auto& vertex : vertices) {
+            origin = glm::min(origin, vertex.position);
+        }
+        float inverse_scale = 1.f / error_scale(vertices);
+
+        std::vector<glm::vec3> positions(vertex_count);
+        for (size_t v = 0; v < vertex_count; v++) {
+            positions[v] = (vertices[v].position - origin) * inverse_scale;
+        }
+
+        // Group vertices by position. Any vertex sharing its position with
+        // another one sits on an attribute seam
+        std::vector<uint32_t> position_group(vertex_count);
+        {
+            std::vector<uint32_t> order(vertex_count);
+            std::iota(order.begin(), order.end(), 0);
+            auto less = [&](uint32_t a, uint32_t b) {
+                return std::memcmp(&vertices[a].position, &vertices[b].position, sizeof(glm::vec3)) < 0;
+            };
+            std::sort(order.begin(), order.end(), less);
+
+            for (size_t i = 0; i < vertex_count; i++) {
+                bool same = i > 0 && !less(order[i - 1], order[i]);
+                position_group[order[i]] = same ? position_group[order[i - 1]] : order[i];
+            }
+        }
+
+        std::vector<uint8_t> kind(vertex_count, KIND_MANIFOLD);
+        {
+            std::vector<uint32_t> group_size(vertex_count, 0);
+            for (size_t v = 0; v < vertex_count; v++) {
+                group_size[position_group[v]]++;
+            }
+            for (size_t v = 0; v < vertex_count; v++) {
+                if (group_size[position_group[v]] > 1) kind[v] = KIND_LOCKED;
+            }
+        }
+
+        // Count triangles per edge on position groups. One triangle means an
+        // open border, more than two a non-manifold edge
+        std::unordered_map<uint64_t, uint32_t> edge_use;
+        edge_use.reserve(result.size());
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = position_group[result[i + k]];
+                uint32_t b = position_group[result[i + (k + 1) % 3]];
+                edge_use[edge_key(a, b)]++;
+            }
+        }
+
+        auto edge_count = [&](uint32_t a, uint32_t b) {
+            auto it = edge_use.find(edge_key(position_group[a], position_group[b]));
+            return it == edge_use.end() ? 0u : it->second;
+        };
+
+        // Plane quadrics weighted by area, plus perpendicular planes along
+        // open borders so the outline is preserved
+        std::vector<Quadric> quadrics(vertex_count);
+        for (size_t i = 0; i < result.size(); i += 3) {
+            uint32_t v[3] = {result[i], result[i + 1], result[i + 2]};
+            glm::vec3 p0 = positions[v[0]];
+            glm::vec3 n = glm::cross(positions[v[1]] - p0, positions[v[2]] - p0);
+            float area = glm::length(n);
+            if (area == 0.f) continue;
+            n /= area;
+
+            Quadric face = Quadric::from_plane(n, -glm::dot(n, p0), area);
+            for (uint32_t corner : v) {
+                quadrics[corner] += face;
+            }
+
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = v[k];
+                uint32_t b = v[(k + 1) % 3];
+                uint32_t uses = edge_count(a, b);
+
+                if (uses > 2) {
+                    kind[a] = KIND_LOCKED;
+                    kind[b] = KIND_LOCKED;
+                }
+                if (uses != 1) continue;
+
+                if (kind[a] == KIND_MANIFOLD) kind[a] = KIND_BORDER;
+                if (kind[b] == KIND_MANIFOLD) kind[b] = KIND_BORDER;
+
+                glm::vec3 edge = positions[b] - positions[a];
+                float length = glm::length(edge);
+                if (length == 0.f) continue;
+
+                glm::vec3 m = glm::normalize(glm::cross(edge / length, n));
+                Quadric border = Quadric::from_plane(m, -glm::dot(m, positions[a]), length * length * BORDER_WEIGHT);
+                quadrics[a] += border;
+                quadrics[b] += border;
+            }
+        }
+
+        auto can_collapse = [&](uint32_t from, uint32_t to) {
+            if (kind[from] == KIND_LOCKED) return false;
+            if (kind[from] == KIND_BORDER) {
+                return edge_count(from, to) == 1 && kind[to] != KIND_MANIFOLD;
+            }
+            return true;
+        };
+
+        double error_limit = static_cast<double>(target_error) * target_error;
+        double max_error = 0.0;
+
+        std::vector<uint32_t> remap(vertex_count);
+        std::vector<bool> touched(vertex_count);
+        std::vector<uint32_t> adjacency_offsets(vertex_count + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+
+        while (result.size() > target_index_count) {
+            // Vertex -> triangle adjacency of the current index list
+            std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+            for (uint32_t index : result) {
+                adjacency_offsets[index + 1]++;
+            }
+            std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+            adjacency.resize(result.size());
+            {
+                std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+                for (size_t i = 0; i < result.size(); i++) {
+                    adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            // Cheapest valid direction of every edge
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int k = 0; k < 3; k++) {
+                    uint32_t a = result[i + k];
+                    uint32_t b = result[i + (k + 1) % 3];
+
+                    Quadric q = quadrics[a];
+                    q += quadrics[b];
+                    double weight = q.weight > 0.0 ? q.weight : 1.0;
+
+                    double cost_ab = can_collapse(a, b) ? q.evaluate(positions[b]) / weight : -1.0;
+                    double cost_ba = can_collapse(b, a) ? q.evaluate(positions[a]) / weight : -1.0;
+
+                    if (cost_ab >= 0.0 && (cost_ba < 0.0 || cost_ab <= cost_ba)) {
+                        collapses.push_back({a, b, cost_ab});
+                    } else if (cost_ba >= 0.0) {
+                        collapses.push_back({b, a, cost_ba});
+                    }
+                }
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+                return x.cost < y.cost;
+            });
+
+            // Apply a batch of independent collapses, cheapest first. Every
+            // vertex around a collapsed one is frozen for the rest of the pass
+            // so the flip checks below stay valid
+            std::iota(remap.begin(), remap.end(), 0);
+            std::fill(touched.begin(), touched.end(), false);
+
+            size_t triangles_to_remove = (result.size() - target_index_count) / 3;
+            size_t triangles_removed = 0;
+            size_t collapse_count = 0;
+
+            for (const Collapse& collapse : collapses) {
+                if (collapse.cost > error_limit) break;
+                if (triangles_removed >= triangles_to_remove) break;
+
+                uint32_t from = collapse.from;
+                uint32_t to = collapse.to;
+                if (touched[from] || touched[to]) continue;
+
+                // Reject collapses that flip or degenerate a surviving triangle
+                bool flips = false;
+                uint32_t removed = 0;
+                for (uint32_t a = adjacency_offsets[from]; a < adjacency_offsets[from + 1] && !flips; a++) {
+                    const uint32_t* triangle = &result[3 * adjacency[a]];
+                    if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+                        removed++;
+                        continue;
+                    }
+
+                    glm::vec3 p[3];
+                    glm::vec3 q[3];
+                    for (int k = 0; k < 3; k++) {
+                        p[k] = positions[triangle[k]];
+                        q[k] = triangle[k] == from ? positions[to] : p[k];
+                    }
+                    glm::vec3 n_old = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    glm::vec3 n_new = glm::cross(q[1] - q[0], q[2] - q[0]);
+                    flips = glm::dot(n_old, n_new) <= 0.f;
+                }
+                if (flips) continue;
+
+                for (uint32_t a = adjacency_offsets[from]; a < adjacency_offsets[from + 1]; a++) {
+                    const uint32_t* triangle = &result[3 * adjacency[a]];
+                    touched[triangle[0]] = true;
+                    touched[triangle[1]] = true;
+                    touched[triangle[2]] = true;
+                }
+
+                remap[from] = to;
+                quadrics[to] += quadrics[from];
+                max_error = std::max(max_error, collapse.cost);
+                triangles_removed += removed;
+                collapse_count++;
+            }
+
+            if (collapse_count == 0) break;
+
+            // Rewrite the index list and drop triangles that became degenerate
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3) {
+                uint32_t a = remap[result[i]];
+                uint32_t b = remap[result[i + 1]];
+                uint32_t c = remap[result[i + 2]];
+                if (a == b || b == c || a == c) continue;
+
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        if (result_error) {
+            *result_error = static_cast<float>(std::sqrt(max_error));
+        }
+        return result;
+    }
+
+} // cge
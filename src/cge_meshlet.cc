@@ -0,0 +1,255 @@
+#include "cge_meshlet.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cge {
+
+    static glm::vec3 load_position(const float* positions, size_t vertex_stride, uint32_t index) {
+        const float* p = reinterpret_cast<const float*>(
+            reinterpret_cast<const char*>(positions) + index * vertex_stride);
+        return glm::vec3{p[0], p[1], p[2]};
+    }
+
+    // Fill in the bounding sphere and normal cone of a finished meshlet
+    static void compute_bounds(
+        CGE_Meshlet& meshlet,
+        const float* positions,
+        size_t vertex_stride,
+        const uint32_t* indices
+    ) {
+        const uint32_t* triangles = indices + meshlet.first_index;
+        uint32_t corner_count = meshlet.triangle_count * 3;
+
+        // Sphere around the center of the AABB
+        glm::vec3 bounds_min = load_position(positions, vertex_stride, triangles[0]);
+        glm::vec3 bounds_max = bounds_min;
+        for (uint32_t i = 1; i < corner_count; i++) {
+            glm::vec3 p = load_position(positions, vertex_stride, triangles[i]);
+            bounds_min = glm::min(bounds_min, p);
+            bounds_max = glm::max(bounds_max, p);
+        }
+
+        meshlet.center = (bounds_min + bounds_max) * 0.5f;
+        float radius_squared = 0.f;
+        for (uint32_t i = 0; i < corner_count; i++) {
+            glm::vec3 d = load_position(positions, vertex_stride, triangles[i]) - meshlet.center;
+            radius_squared = std::max(radius_squared, glm::dot(d, d));
+        }
+        meshlet.radius = std::sqrt(radius_squared);
+
+        // Normal cone: the axis is the mean of the unit triangle normals and
+        // the spread is the widest angle any triangle makes with it
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec3> centroids;
+        normals.reserve(meshlet.triangle_count);
+        centroids.reserve(meshlet.triangle_count);
+
+        glm::vec3 axis{0.f};
+        for (uint32_t t = 0; t < meshlet.triangle_count; t++) {
+            glm::vec3 p0 = load_position(positions, vertex_stride, triangles[3 * t + 0]);
+            glm::vec3 p1 = load_position(positions, vertex_stride, triangles[3 * t + 1]);
+            glm::vec3 p2 = load_position(positions, vertex_stride, triangles[3 * t + 2]);
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(n);
+            if (length == 0.f) continue;
+
+            normals.push_back(n / length);
+            centroids.push_back((p0 + p1 + p2) / 3.f);
+            axis += normals.back();
+        }
+
+        meshlet.cone_apex = meshlet.center;
+        meshlet.cone_axis = glm::vec3{0.f, 0.f, 1.f};
+        meshlet.cone_cutoff = 1.f;
+
+        float axis_length = glm::length(axis);
+        if (normals.empty() || axis_length == 0.f) {
+            return;
+        }
+        axis /= axis_length;
+
+        float min_dot = 1.f;
+        for (const glm::vec3& n : normals) {
+            min_dot = std::min(min_dot, glm::dot(n, axis));
+        }
+
+        // Triangles facing more than ~84 degrees apart can never all be back
+        // facing at once, leave the cone disabled
+        if (min_dot <= 0.1f) {
+            return;
+        }
+
+        // Move the apex back along the axis until it is behind every triangle
+        // plane, so the test holds for any point of the meshlet
+        float max_t = 0.f;
+        for (size_t i = 0; i < normals.size(); i++) {
+            float dc = glm::dot(centroids[i] - meshlet.center, normals[i]);
+            float dn = glm::dot(axis, normals[i]);
+            max_t = std::max(max_t, dc / dn);
+        }
+
+        meshlet.cone_apex = meshlet.center - axis * max_t;
+        meshlet.cone_axis = axis;
+        meshlet.cone_cutoff = std::sqrt(1.f - min_dot * min_dot);
+    }
+
+    void
+    CGE_Meshlet_Builder::build(
+        const float* positions,
+        size_t vertex_count,
+        size_t vertex_stride,
+        const uint32_t* indices,
+        size_t index_count,
+        std::vector<CGE_Meshlet>& meshlets
+    ) {
+        meshlets.clear();
+        if (index_count < 3) {
+            return;
+        }
+
+        // last_meshlet[v] is the meshlet that last referenced v, so checking
+        // whether a vertex is already in the current meshlet is one compare
+        constexpr uint32_t NONE = 0xFFFFFFFFu;
+        std::vector<uint32_t> last_meshlet(vertex_count, NONE);
+
+        CGE_Meshlet current{};
+        uint32_t meshlet_id = 0;
+
+        auto finish = [&](uint32_t end_index) {
+            current.triangle_count = (end_index - current.first_index) / 3;
+            compute_bounds(current, positions, vertex_stride, indices);
+            meshlets.push_back(current);
+
+            current = CGE_Meshlet{};
+            current.first_index = end_index;
+            meshlet_id++;
+        };
+
+        // Distinct vertices of triangle i not yet in the current meshlet
+        auto count_new_vertices = [&](size_t i) {
+            uint32_t count = 0;
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[i + k];
+                bool seen = last_meshlet[v] == meshlet_id;
+                for (int j = 0; j < k && !seen; j++) {
+                    seen = indices[i + j] == v;
+                }
+                count += seen ? 0 : 1;
+            }
+            return count;
+        };
+
+        for (size_t i = 0; i + 2 < index_count; i += 3) {
+            uint32_t new_vertices = count_new_vertices(i);
+            uint32_t triangle_count = (static_cast<uint32_t>(i) - current.first_index) / 3;
+
+            if (current.vertex_count + new_vertices > MAX_VERTICES || triangle_count + 1 > MAX_TRIANGLES) {
+                finish(static_cast<uint32_t>(i));
+                new_vertices = count_new_vertices(i);
+            }
+
+            for (int k = 0; k < 3; k++) {
+                last_meshlet[indices[i + k]] = meshlet_id;
+            }
+            current.vertex_count += new_vertices;
+        }
+
+        finish(static_cast<uint32_t>(index_count - index_count % 3));
+    }
+
+    CGE_Frustum
+    CGE_Frustum::from_matrix(const glm::mat4& clip) {
+        // glm is column major, row r of the matrix is (clip[0][r], clip[1][r], ...)
+        auto row = [&](int r) {
+            return glm::vec4{clip[0][r], clip[1][r], clip[2][r], clip[3][r]};
+        };
+
+        glm::vec4 x = row(0);
+        glm::vec4 y = row(1);
+        glm::vec4 z = row(2);
+        glm::vec4 w = row(3);
+
+        CGE_Frustum frustum{};
+        frustum.planes[0] = w + x;  // left
+        frustum.planes[1] = w - x;  // right
+        frustum.planes[2] = w + y;  // top (Vulkan y points down)
+        frustum.planes[3] = w - y;  // bottom
+        frustum.planes[4] = z;      // near, depth 0..1
+        frustum.planes[5] = w - z;  // far
+
+        for (glm::vec4& plane : frustum.planes) {
+            float length = glm::length(glm::vec3{plane.x, plane.y, plane.z});
+            if (length > 0.f) {
+                plane /= length;
+            }
+        }
+        return frustum;
+    }
+
+    bool
+    CGE_Frustum::intersects_sphere(const glm::vec3& center, float radius) const {
+        for (const glm::vec4& plane : planes) {
+            if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool
+    cge_meshlet_backfacing(const CGE_Meshlet& meshlet, const glm::vec3& camera_position) {
+        if (meshlet.cone_cutoff >= 1.f) {
+            return false;
+        }
+
+        glm::vec3 view = meshlet.cone_apex - camera_position;
+        float distance = glm::length(view);
+        if (distance == 0.f) {
+            return false;
+        }
+        return glm::dot(view, meshlet.cone_axis) >= meshlet.cone_cutoff * distance;
+    }
+
+    uint32_t
+    cge_cull_meshlets(
+        const CGE_Meshlet* meshlets,
+        uint32_t meshlet_count,
+        const CGE_Frustum& frustum,
+        const glm::vec3* camera_position,
+        VkDrawIndexedIndirectCommand* out,
+        uint32_t first_index,
+        int32_t vertex_offset
+    ) {
+        uint32_t command_count = 0;
+        bool extend = false;
+
+        for (uint32_t i = 0; i < meshlet_count; i++) {
+            const CGE_Meshlet& meshlet = meshlets[i];
+            bool visible = frustum.intersects_sphere(meshlet.center, meshlet.radius)
+                           && !(camera_position && cge_meshlet_backfacing(meshlet, *camera_position));
+            if (!visible) {
+                extend = false;
+                continue;
+            }
+
+            uint32_t index_count = meshlet.triangle_count * 3;
+            if (extend) {
+                out[command_count - 1].indexCount += index_count;
+                continue;
+            }
+
+            VkDrawIndexedIndirectCommand& command = out[command_count++];
+            command.indexCount = index_count;
+            command.instanceCount = 1;
+            command.firstIndex = first_index + meshlet.first_index;
+            command.vertexOffset = vertex_offset;
+            command.firstInstance = 0;
+            extend = true;
+        }
+
+        return command_count;
+    }
+
+} // cge
@@ -1,14 +1,13 @@
 #include "cge_model.hh"
-
+#include "cge_mesh_cache.hh"
+#include "cge_mesh_optimizer.hh"
+#include "cge_mesh_simplifier.hh"
 #include "utils.hh"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tinyobjloader/tinyobjloader.hh>
-
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include "cge_obj_loader.hh"
+#include "cge_vertex_map.hh"
 
-#include <unordered_map>
+#include <algorithm>
 #include <stdexcept>
 #include <cstdint>
 #include <cstring>
@@ -17,217 +16,561 @@
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
-namespace std {
-    
-    template<>
-    struct hash<cge::CGE_Model::Vertex>{
-        size_t operator()(cge::CGE_Model::Vertex const &vertex) const {
-            size_t seed = 0;
-            cge::hash_combine(seed, vertex.position, vertex.color, vertex.normals, vertex.uv);
-            return seed;
+namespace cge {
+
+    // Flags that put static geometry where the host can write it in place,
+    // on devices where that memory is the main VRAM heap
+    static VkMemoryPropertyFlags direct_write_flags(CGE_Device& device) {
+        return device.memoryAllocator().uses_direct_write()
+            ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            : 0;
+    }
+
+    // Copy data into dst at offset: a memcpy when dst is host visible,
+    // otherwise a staged copy recorded on the batcher
+    static void upload(
+        CGE_Device& device,
+        CGE_Buffer& dst,
+        const void* data,
+        VkDeviceSize size,
+        VkDeviceSize offset,
+        CGE_Upload_Batcher& batcher
+    ) {
+        if (!dst.is_host_visible()) {
+            batcher.upload(dst.get_buffer(), data, size, offset);
+            return;
+        }
+
+        if (!dst.get_mapped_memory()) {
+            dst.map();
+        }
+        std::memcpy(static_cast<char*>(dst.get_mapped_memory()) + offset, data, size);
+        if (!(dst.get_memory_property_flags() & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            dst.flush();
+        }
+        device.memoryAllocator().record_upload(size, true);
+    }
+    CGE_Model::CGE_Model(CGE_Device &device, const CGE_Model::Builder& builder)
+        : CGE_Model(device, builder.view(), builder.vertex_format) {}
+
+    // Create a model straight from imported geometry, e.g. a mapped .cgemesh
+    CGE_Model::CGE_Model(
+        CGE_Device &device,
+        const Mesh_View& mesh,
+        CGE_Vertex_Format vertex_format,
+        CGE_Upload_Batcher* batcher,
+        CGE_Geometry_Pool* pool
+    ) : _device{device}, _vertex_format{vertex_format} {
+        if (pool && pool->get_vertex_format() == vertex_format) {
+            _pool_allocation = pool->allocate(mesh.vertex_count, mesh.index_count);
+            if (_pool_allocation.valid()) {
+                _pool = pool;
+                _base_vertex = _pool_allocation.first_vertex;
+                _first_index = mesh.index_count > 0 ? _pool_allocation.first_index : 0;
+            }
         }
-    };
 
-} // std
+        // Without a batcher both buffers still go up in a single submit
+        std::unique_ptr<CGE_Upload_Batcher> own_batcher;
+        if (!batcher) {
+            own_batcher = std::make_unique<CGE_Upload_Batcher>(device);
+            batcher = own_batcher.get();
+        }
 
-namespace cge {
-    CGE_Model::CGE_Model(CGE_Device &device, const CGE_Model::Builder& builder) : _device{device} {
-        this->_create_vertex_buffers(builder.vertices);
-        this->_create_index_buffers(builder.indices);
+        this->_create_vertex_buffers(mesh.vertices, mesh.vertex_count, *batcher);
+        this->_create_index_buffers(mesh.indices, mesh.index_count, *batcher);
+
+        if (own_batcher) {
+            own_batcher->flush();
+        }
+
+        if (!_has_index_buffer)
+            return;
+
+        if (mesh.meshlets) {
+            _meshlets.assign(mesh.meshlets, mesh.meshlets + mesh.meshlet_count);
+        }
+
+        // Geometry without LOD information is a single level covering everything
+        if (mesh.lods && mesh.lod_count > 0) {
+            _lods.assign(mesh.lods, mesh.lods + mesh.lod_count);
+        } else {
+            Lod lod{};
+            lod.index_count = _index_count;
+            lod.meshlet_count = static_cast<uint32_t>(_meshlets.size());
+            _lods.push_back(lod);
+        }
     }
 
     CGE_Model::~CGE_Model() {
-
+        if (_pool) {
+            _pool->free(_pool_allocation);
+        }
     }
 
     void
-    CGE_Model::_create_index_buffers(const std::vector<uint32_t> &indices) {
-        _index_count = static_cast<uint32_t>(indices.size());
+    CGE_Model::_create_index_buffers(const uint32_t* indices, uint32_t index_count, CGE_Upload_Batcher& batcher) {
+        _index_count = index_count;
         _has_index_buffer = _index_count > 0;
 
         if (!_has_index_buffer)
             return;
 
-        VkDeviceSize buffer_size = sizeof(indices[0]) * _index_count;
+        // Pooled models share the pool's 32-bit index buffer
+        if (_pool) {
+            _index_type = VK_INDEX_TYPE_UINT32;
+            upload(
+                _device,
+                _pool->get_index_buffer(),
+                indices,
+                static_cast<VkDeviceSize>(_index_count) * sizeof(uint32_t),
+                static_cast<VkDeviceSize>(_first_index) * sizeof(uint32_t),
+                batcher);
+            return;
+        }
+
+        // Halve the index buffer whenever every index fits in 16 bits.
+        // Primitive restart is disabled, so 0xFFFF is an ordinary index
+        std::vector<uint16_t> short_indices;
+        const void* index_data = indices;
         uint32_t index_size = sizeof(indices[0]);
+        _index_type = VK_INDEX_TYPE_UINT32;
 
-        CGE_Buffer staging_buffer {
-            _device,
-            index_size,
-            _index_count,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
+        if (_vertex_count <= 0x10000) {
+            short_indices.assign(indices, indices + _index_count);
+            index_data = short_indices.data();
+            index_size = sizeof(uint16_t);
+            _index_type = VK_INDEX_TYPE_UINT16;
+        }
 
-        staging_buffer.map();
-        staging_buffer.write_to_buffer((void*)indices.data());
+        VkDeviceSize buffer_size = static_cast<VkDeviceSize>(index_size) * _index_count;
 
         _index_buffer = std::make_unique<CGE_Buffer>(
             _device,
             index_size,
             _index_count,
             VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            1,
+            direct_write_flags(_device)
         );
 
-        
-        // Move content of the staging buffer to the index buffer
-        _device.copyBuffer(staging_buffer.get_buffer(), _index_buffer->get_buffer(), buffer_size);
+        upload(_device, *_index_buffer, index_data, buffer_size, 0, batcher);
     }
 
 
     std::unique_ptr<CGE_Model> 
     CGE_Model::create_model_from_file(
         CGE_Device& device, 
-        const std::string &filepath
+        const std::string &filepath,
+        bool optimize,
+        CGE_Vertex_Format vertex_format,
+        CGE_Geometry_Pool* pool
     ) {
         Builder builder{};
+        builder.optimize = optimize;
+        builder.vertex_format = vertex_format;
+
+        // Fast path: geometry imported on a previous launch is mapped and
+        // copied directly into the staging buffers
+        if (auto cached = CGE_Mesh_Cache::load(filepath, builder.cache_key())) {
+            std::cout << "Vertex Count: " << cached->vertex_count() << " (cached)" << std::endl;
+
+            return std::make_unique<CGE_Model>(device, cached->view(), vertex_format, nullptr, pool);
+        }
+
         builder.load_models(filepath);
 
         std::cout << "Vertex Count: " << builder.vertices.size() << std::endl;
 
-        return std::make_unique<CGE_Model>(device, builder);
+        return std::make_unique<CGE_Model>(device, builder.view(), vertex_format, nullptr, pool);
     }
 
 
     void
-    CGE_Model::_create_vertex_buffers(const std::vector<Vertex> &vertices) {
-        this->_vertex_count = static_cast<uint32_t>(vertices.size());
+    CGE_Model::_create_vertex_buffers(const Vertex* vertices, uint32_t vertex_count, CGE_Upload_Batcher& batcher) {
+        this->_vertex_count = vertex_count;
         assert(this->_vertex_count >= 3 && "Vertex count must be at least 3");
-        
-        VkDeviceSize buffer_size = sizeof(vertices[0]) * this->_vertex_count;
 
+        // Bounding sphere around the center of the AABB, used for LOD selection
+        glm::vec3 bounds_min = vertices[0].position;
+        glm::vec3 bounds_max = vertices[0].position;
+        for (uint32_t i = 1; i < vertex_count; i++) {
+            bounds_min = glm::min(bounds_min, vertices[i].position);
+            bounds_max = glm::max(bounds_max, vertices[i].position);
+        }
+        _bounds_center = (bounds_min + bounds_max) * 0.5f;
+        _bounds_radius = glm::length(bounds_max - bounds_min) * 0.5f;
+
+        std::vector<CGE_Packed_Vertex> packed_vertices;
+        const void* vertex_data = vertices;
         uint32_t vertex_size = sizeof(vertices[0]);
 
-        CGE_Buffer staging_buffer{
-            _device,
-            vertex_size,
-            _vertex_count,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
+        if (_vertex_format != CGE_Vertex_Format::FULL) {
+            packed_vertices = _pack_vertices(vertices, vertex_count);
+            vertex_data = packed_vertices.data();
+            vertex_size = sizeof(CGE_Packed_Vertex);
+        }
 
-        staging_buffer.map();
-        staging_buffer.write_to_buffer((void*)vertices.data());
+        VkDeviceSize buffer_size = static_cast<VkDeviceSize>(vertex_size) * this->_vertex_count;
+
+        if (_pool) {
+            upload(
+                _device,
+                _pool->get_vertex_buffer(),
+                vertex_data,
+                buffer_size,
+                static_cast<VkDeviceSize>(_base_vertex) * vertex_size,
+                batcher);
+            return;
+        }
 
         _vertex_buffer = std::make_unique<CGE_Buffer>(
             _device,
             vertex_size,
             _vertex_count,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            vertex_buffer_usage(_device),
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            1,
+            direct_write_flags(_device)
         );
 
-        // Move content of the staging buffer to the index buffer
-        _device.copyBuffer(staging_buffer.get_buffer(), _vertex_buffer->get_buffer(), buffer_size);
+        upload(_device, *_vertex_buffer, vertex_data, buffer_size, 0, batcher);
+    }
+
+    // Quantize vertices into the model's packed format.
+    // Positions are stored relative to the center of the mesh bounds, and
+    // _dequantization is set to the matrix that undoes it
+    std::vector<CGE_Packed_Vertex>
+    CGE_Model::_pack_vertices(const Vertex* vertices, uint32_t vertex_count) {
+        glm::vec3 bounds_min = vertices[0].position;
+        glm::vec3 bounds_max = vertices[0].position;
+        for (uint32_t i = 1; i < vertex_count; i++) {
+            bounds_min = glm::min(bounds_min, vertices[i].position);
+            bounds_max = glm::max(bounds_max, vertices[i].position);
+        }
+
+        glm::vec3 center = (bounds_min + bounds_max) * 0.5f;
+        glm::vec3 scale{1.f};
+        if (_vertex_format == CGE_Vertex_Format::PACKED_SNORM) {
+            scale = (bounds_max - bounds_min) * 0.5f;
+            for (int axis = 0; axis < 3; axis++) {
+                if (scale[axis] <= 0.f) scale[axis] = 1.f;
+            }
+        }
+
+        _dequantization = glm::mat4{1.f};
+        _dequantization[0][0] = scale.x;
+        _dequantization[1][1] = scale.y;
+        _dequantization[2][2] = scale.z;
+        _dequantization[3] = glm::vec4{center, 1.f};
+
+        std::vector<CGE_Packed_Vertex> packed(vertex_count);
+        for (uint32_t i = 0; i < vertex_count; i++) {
+            const Vertex& vertex = vertices[i];
+            CGE_Packed_Vertex& out = packed[i];
+
+            glm::vec3 position = (vertex.position - center) / scale;
+            for (int axis = 0; axis < 3; axis++) {
+                out.position[axis] = _vertex_format == CGE_Vertex_Format::PACKED_SNORM
+                    ? static_cast<uint16_t>(cge_pack_snorm16(position[axis]))
+                    : cge_pack_half(position[axis]);
+            }
+            out.position[3] = 0;
+
+            glm::vec2 normal = cge_encode_octahedral(vertex.normals);
+            out.normal[0] = cge_pack_snorm16(normal.x);
+            out.normal[1] = cge_pack_snorm16(normal.y);
+
+            out.color[0] = cge_pack_unorm8(vertex.color.x);
+            out.color[1] = cge_pack_unorm8(vertex.color.y);
+            out.color[2] = cge_pack_unorm8(vertex.color.z);
+            out.color[3] = 255;
+
+            out.uv[0] = cge_pack_half(vertex.uv.x);
+            out.uv[1] = cge_pack_half(vertex.uv.y);
+        }
+
+        return packed;
     }
 
     void
-    CGE_Model::_draw(VkCommandBuffer command_buffer) {
+    CGE_Model::_draw(VkCommandBuffer command_buffer, uint32_t lod) {
         // If we have an index buffer, use that, otherwise, just use normal draw call
         if (_has_index_buffer) {
-            vkCmdDrawIndexed(command_buffer, _index_count, 1, 0, 0, 0);
+            const Lod& level = _lods[std::min<size_t>(lod, _lods.size() - 1)];
+            vkCmdDrawIndexed(command_buffer, level.index_count, 1, _first_index + level.first_index, get_base_vertex(), 0);
         } else {
-            vkCmdDraw(command_buffer, this->_vertex_count, 1, 0, 0);
+            vkCmdDraw(command_buffer, this->_vertex_count, 1, _base_vertex, 0);
+        }
+    }
+
+    void
+    CGE_Model::_draw_indirect(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count) {
+        if (draw_count == 0)
+            return;
+
+        constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+        if (_device.features.multiDrawIndirect || draw_count == 1) {
+            vkCmdDrawIndexedIndirect(command_buffer, buffer, offset, draw_count, stride);
+            return;
+        }
+
+        for (uint32_t i = 0; i < draw_count; i++) {
+            vkCmdDrawIndexedIndirect(command_buffer, buffer, offset + i * stride, 1, stride);
+        }
+    }
+
+    VkBufferUsageFlags
+    CGE_Model::vertex_buffer_usage(CGE_Device& device) {
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        if (device.bufferDeviceAddressSupported()) {
+            usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
+        }
+        return usage;
+    }
+
+    VkDeviceAddress
+    CGE_Model::get_vertex_address() const {
+        return _pool
+            ? _pool->get_vertex_buffer().get_device_address()
+            : _vertex_buffer->get_device_address();
+    }
+
+    uint32_t
+    CGE_Model::get_vertex_stride() const {
+        return _vertex_format == CGE_Vertex_Format::FULL
+            ? sizeof(Vertex)
+            : sizeof(CGE_Packed_Vertex);
+    }
+
+    void
+    CGE_Model::_bind_indices(VkCommandBuffer command_buffer) {
+        if (_pool) {
+            _pool->_bind_indices(command_buffer);
+            return;
+        }
+
+        if (_has_index_buffer) {
+            vkCmdBindIndexBuffer(command_buffer, _index_buffer->get_buffer(), 0, _index_type);
         }
     }
 
     void
     CGE_Model::_bind(VkCommandBuffer command_buffer) {
+        if (_pool) {
+            _pool->_bind(command_buffer);
+            return;
+        }
+
         VkBuffer buffers[] = {this->_vertex_buffer->get_buffer()};
         VkDeviceSize offsets[] = {0};
         vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
 
         if (_has_index_buffer) {
-            vkCmdBindIndexBuffer(command_buffer, _index_buffer->get_buffer(), 0, VK_INDEX_TYPE_UINT32);
+            vkCmdBindIndexBuffer(command_buffer, _index_buffer->get_buffer(), 0, _index_type);
         }
     }
 
+    using CGE_Full_Vertex_Layout = CGE_Vertex_Layout<
+        CGE_Model::Vertex,
+        CGE_Vertex_Attribute<0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(CGE_Model::Vertex, position)>,
+        CGE_Vertex_Attribute<1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(CGE_Model::Vertex, color)>,
+        CGE_Vertex_Attribute<2, VK_FORMAT_R32G32B32_SFLOAT, offsetof(CGE_Model::Vertex, normals)>,
+        CGE_Vertex_Attribute<3, VK_FORMAT_R32G32_SFLOAT,    offsetof(CGE_Model::Vertex, uv)>>;
+
     // Get the vertex's binding descriptions
     std::vector<VkVertexInputBindingDescription>
     CGE_Model::Vertex::get_binding_description() {
-        std::vector<VkVertexInputBindingDescription> binding_descriptions(1);
-        binding_descriptions[0].binding = 0;
-        binding_descriptions[0].stride = sizeof(Vertex);
-        binding_descriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-        return binding_descriptions;
-
+        return CGE_Full_Vertex_Layout::get_binding_description();
     }
 
     // Get the vertex's attribute descriptions
     std::vector <VkVertexInputAttributeDescription>
     CGE_Model::Vertex::get_attribute_description() {
-        std::vector<VkVertexInputAttributeDescription> attribute_descriptions{};
+        return CGE_Full_Vertex_Layout::get_attribute_description();
+    }
 
-        attribute_descriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)});
-        attribute_descriptions.push_back({1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color)});
-        attribute_descriptions.push_back({2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normals)});
-        attribute_descriptions.push_back({3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)});
+    std::vector<VkVertexInputBindingDescription>
+    CGE_Model::get_binding_description(CGE_Vertex_Format format) {
+        switch (format) {
+            case CGE_Vertex_Format::PACKED_SNORM: return CGE_Packed_Snorm_Layout::get_binding_description();
+            case CGE_Vertex_Format::PACKED_HALF:  return CGE_Packed_Half_Layout::get_binding_description();
+            case CGE_Vertex_Format::FULL:
+            default:                              return CGE_Full_Vertex_Layout::get_binding_description();
+        }
+    }
 
-        return attribute_descriptions;
+    std::vector<VkVertexInputAttributeDescription>
+    CGE_Model::get_attribute_description(CGE_Vertex_Format format) {
+        switch (format) {
+            case CGE_Vertex_Format::PACKED_SNORM: return CGE_Packed_Snorm_Layout::get_attribute_description();
+            case CGE_Vertex_Format::PACKED_HALF:  return CGE_Packed_Half_Layout::get_attribute_description();
+            case CGE_Vertex_Format::FULL:
+            default:                              return CGE_Full_Vertex_Layout::get_attribute_description();
+        }
     }
 
     // Load a model from a wavefront .obj file
     void
     CGE_Model::Builder::load_models(const std::string &filepath) {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
-
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())) {
-            throw std::runtime_error(warn + err);
-        }
+        CGE_Obj_Data obj{};
+        CGE_Obj_Loader::load(filepath, obj);
 
         vertices.clear();
         indices.clear();
+        indices.reserve(obj.corners.size());
+
+        // Every corner is at most one new vertex, so sizing by the index
+        // count means the table never grows during the import
+        CGE_Vertex_Map unique_vertices{obj.corners.size()};
 
-        std::unordered_map<Vertex, uint32_t> unique_vertices{};
-
-        for (const auto &shape : shapes) {
-            for (const auto &index : shape.mesh.indices) {
-                Vertex vertex{};
-
-                // Set the vertex position coords
-                if (index.vertex_index >= 0) {
-                    vertex.position = {
-                        attrib.vertices[3 * index.vertex_index + 0],
-                        attrib.vertices[3 * index.vertex_index + 1],
-                        attrib.vertices[3 * index.vertex_index + 2]
-                    };
-
-                    // Extend unofficial support for colored vertices
-                    // if provided
-                    vertex.color = {
-                        attrib.colors[3 * index.vertex_index + 0],
-                        attrib.colors[3 * index.vertex_index + 1],
-                        attrib.colors[3 * index.vertex_index + 2]
-                    };
-                }
-
-                // Set hte vertex normal coords
-                if (index.normal_index >= 0) {
-                    vertex.normals = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2]
-                    };
-                }
-
-                // Set the vertex texture coords
-                if (index.texcoord_index >= 0) {
-                    vertex.uv = {
-                        attrib.texcoords[2 * index.texcoord_index + 1],
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                    };
-                }
-
-                if (unique_vertices.count(vertex) == 0) {
-                    unique_vertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
-                indices.push_back(unique_vertices[vertex]);
+        for (const auto &corner : obj.corners) {
+            Vertex vertex{};
+
+            // Set the vertex position coords
+            if (corner.position >= 0) {
+                const float *position = &obj.positions[3 * corner.position];
+                vertex.position = {position[0], position[1], position[2]};
+
+                // Extend unofficial support for colored vertices
+                // if provided
+                const float *color = &obj.colors[3 * corner.position];
+                vertex.color = {color[0], color[1], color[2]};
             }
+
+            // Set hte vertex normal coords
+            if (corner.normal >= 0) {
+                const float *normal = &obj.normals[3 * corner.normal];
+                vertex.normals = {normal[0], normal[1], normal[2]};
+            }
+
+            // Set the vertex texture coords
+            if (corner.texcoord >= 0) {
+                const float *texcoord = &obj.texcoords[2 * corner.texcoord];
+                vertex.uv = {texcoord[1], texcoord[0]};
+            }
+
+            indices.push_back(unique_vertices.find_or_insert(vertex, vertices));
         }
+
+        if (optimize) {
+            CGE_Vertex_Cache_Stats before{};
+            CGE_Vertex_Cache_Stats after{};
+            CGE_Mesh_Optimizer::optimize(*this, &before, &after);
+
+            std::cout << "Mesh optimizer (" << filepath << "): "
+                      << "ACMR " << before.acmr << " -> " << after.acmr << ", "
+                      << "ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+        }
+
+        _generate_lods();
+        _generate_meshlets();
+
+        for (size_t i = 1; i < lods.size(); i++) {
+            std::cout << "LOD " << i << " (" << filepath << "): "
+                      << lods[i].index_count / 3 << " triangles, error " << lods[i].error << std::endl;
+        }
+
+        if (write_cache && !CGE_Mesh_Cache::store(filepath, *this)) {
+            std::cerr << "Warning: failed to write mesh cache for " << filepath << std::endl;
+        }
+    }
+
+    // Simplify level 0 into the coarser levels and append their indices.
+    // Every level is simplified from the full mesh so its error is measured
+    // against it directly
+    void
+    CGE_Model::Builder::_generate_lods() {
+        lods.clear();
+
+        Lod base{};
+        base.index_count = static_cast<uint32_t>(indices.size());
+        lods.push_back(base);
+
+        size_t triangle_count = indices.size() / 3;
+        if (triangle_count < lod_settings.min_triangles) {
+            return;
+        }
+
+        std::vector<uint32_t> base_indices = indices;
+        float error_scale = CGE_Mesh_Simplifier::error_scale(vertices);
+
+        for (float ratio : lod_settings.ratios) {
+            size_t target_index_count = static_cast<size_t>(triangle_count * ratio) * 3;
+            uint32_t previous_count = lods.back().index_count;
+
+            float error = 0.f;
+            std::vector<uint32_t> level = CGE_Mesh_Simplifier::simplify(
+                vertices, base_indices, target_index_count, lod_settings.max_error, &error);
+
+            // Stop once simplification can no longer make a real difference
+            if (level.empty() || level.size() > previous_count * 9 / 10) {
+                break;
+            }
+
+            if (optimize) {
+                CGE_Mesh_Optimizer::optimize_vertex_cache(level, vertices.size());
+            }
+
+            Lod lod{};
+            lod.first_index = static_cast<uint32_t>(indices.size());
+            lod.index_count = static_cast<uint32_t>(level.size());
+            lod.error = std::max(error * error_scale, lods.back().error);
+            lods.push_back(lod);
+
+            indices.insert(indices.end(), level.begin(), level.end());
+        }
+    }
+
+    // Split every level into culling clusters. Runs after optimizing so the
+    // clusters follow the reordered index stream
+    void
+    CGE_Model::Builder::_generate_meshlets() {
+        meshlets.clear();
+        if (vertices.empty()) {
+            return;
+        }
+
+        std::vector<CGE_Meshlet> level_meshlets;
+        for (Lod& lod : lods) {
+            CGE_Meshlet_Builder::build(
+                &vertices[0].position.x,
+                vertices.size(),
+                sizeof(Vertex),
+                indices.data() + lod.first_index,
+                lod.index_count,
+                level_meshlets);
+
+            lod.first_meshlet = static_cast<uint32_t>(meshlets.size());
+            lod.meshlet_count = static_cast<uint32_t>(level_meshlets.size());
+            for (CGE_Meshlet& meshlet : level_meshlets) {
+                meshlet.first_index += lod.first_index;
+                meshlets.push_back(meshlet);
+            }
+        }
+    }
+
+    uint64_t
+    CGE_Model::Builder::cache_key() const {
+        uint64_t key = hash_bytes(&optimize, sizeof(optimize));
+        key = hash_bytes(lod_settings.ratios.data(), lod_settings.ratios.size() * sizeof(float), key);
+        key = hash_bytes(&lod_settings.max_error, sizeof(lod_settings.max_error), key);
+        key = hash_bytes(&lod_settings.min_triangles, sizeof(lod_settings.min_triangles), key);
+        return key;
+    }
+
+    CGE_Model::Mesh_View
+    CGE_Model::Builder::view() const {
+        Mesh_View mesh{};
+        mesh.vertices = vertices.data();
+        mesh.vertex_count = static_cast<uint32_t>(vertices.size());
+        mesh.indices = indices.data();
+        mesh.index_count = static_cast<uint32_t>(indices.size());
+        mesh.meshlets = meshlets.data();
+        mesh.meshlet_count = static_cast<uint32_t>(meshlets.size());
+        mesh.lods = lods.data();
+        mesh.lod_count = static_cast<uint32_t>(lods.size());
+        return mesh;
     }
 }
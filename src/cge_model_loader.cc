@@ -0,0 +1,183 @@
+#include "cge_model_loader.hh"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+namespace cge {
+
+    CGE_Model_Loader::CGE_Model_Loader(CGE_Device& device, CGE_Geometry_Pool* pool)
+        : _device{device}, _pool{pool}, _batcher{device} {
+        _worker = std::thread(&CGE_Model_Loader::_worker_main, this);
+    }
+
+    CGE_Model_Loader::~CGE_Model_Loader() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _work_ready.notify_all();
+        _worker.join();
+
+        // Copies still executing write to buffers owned by the pending models
+        _batcher.flush();
+    }
+
+    std::shared_ptr<CGE_Model_Handle>
+    CGE_Model_Loader::load_async(
+        const std::string& file_path,
+        bool optimize,
+        CGE_Vertex_Format vertex_format
+    ) {
+        auto handle = std::make_shared<CGE_Model_Handle>();
+        handle->_path = file_path;
+        handle->_optimize = optimize;
+        handle->_vertex_format = vertex_format;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queue.push_back(handle);
+        }
+        _work_ready.notify_one();
+        return handle;
+    }
+
+    bool
+    CGE_Model_Loader::is_busy() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _parsing || !_queue.empty() || !_parsed.empty() || !_in_flight.empty();
+    }
+
+    //
+    // Worker: import (or map the cache of) one model at a time
+    //
+    void
+    CGE_Model_Loader::_worker_main() {
+        for (;;) {
+            std::shared_ptr<CGE_Model_Handle> handle;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _work_ready.wait(lock, [this] { return _stopping || !_queue.empty(); });
+                if (_stopping)
+                    return;
+
+                handle = std::move(_queue.front());
+                _queue.pop_front();
+                _parsing = true;
+            }
+
+            auto upload = std::make_unique<Pending_Upload>();
+            upload->handle = handle;
+
+            try {
+                CGE_Model::Builder& builder = upload->builder;
+                builder.optimize = handle->_optimize;
+                builder.vertex_format = handle->_vertex_format;
+
+                upload->cached = CGE_Mesh_Cache::load(handle->_path, builder.cache_key());
+                if (upload->cached) {
+                    upload->mesh = upload->cached->view();
+                } else {
+                    builder.load_models(handle->_path);
+                    upload->mesh = builder.view();
+                }
+
+                if (upload->mesh.vertex_count < 3) {
+                    throw std::runtime_error("Error: model has no geometry: " + handle->_path);
+                }
+
+                const CGE_Model::Vertex* vertices = upload->mesh.vertices;
+                glm::vec3 bounds_min = vertices[0].position;
+                glm::vec3 bounds_max = vertices[0].position;
+                for (uint32_t i = 1; i < upload->mesh.vertex_count; i++) {
+                    bounds_min = glm::min(bounds_min, vertices[i].position);
+                    bounds_max = glm::max(bounds_max, vertices[i].position);
+                }
+                handle->_bounds_min = bounds_min;
+                handle->_bounds_max = bounds_max;
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to load " << handle->_path << ": " << e.what() << std::endl;
+                handle->_error = e.what();
+                handle->_state.store(CGE_Model_Handle::State::FAILED, std::memory_order_release);
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                _parsing = false;
+                continue;
+            }
+
+            handle->_state.store(CGE_Model_Handle::State::PARSED, std::memory_order_release);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _parsed.push_back(std::move(upload));
+            _parsing = false;
+        }
+    }
+
+    //
+    // Main thread: submit new uploads and retire finished ones
+    //
+    void
+    CGE_Model_Loader::update() {
+        for (auto it = _in_flight.begin(); it != _in_flight.end();) {
+            if (!_batcher.is_complete((*it)->batch)) {
+                ++it;
+                continue;
+            }
+
+            this->_finish_upload(**it);
+            it = _in_flight.erase(it);
+        }
+
+        std::vector<Pending_Upload*> recorded;
+        while (_batcher.get_recorded_bytes() < UPLOAD_BUDGET) {
+            std::unique_ptr<Pending_Upload> upload;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_parsed.empty())
+                    break;
+
+                upload = std::move(_parsed.front());
+                _parsed.pop_front();
+            }
+
+            this->_record_upload(*upload);
+            recorded.push_back(upload.get());
+            _in_flight.push_back(std::move(upload));
+        }
+
+        // Everything recorded this frame goes out in one submit
+        if (!recorded.empty()) {
+            uint64_t batch = _batcher.submit();
+            for (Pending_Upload* upload : recorded) {
+                upload->batch = batch;
+                upload->handle->_state.store(CGE_Model_Handle::State::UPLOADING, std::memory_order_release);
+            }
+        }
+    }
+
+    // Create the model's buffers and record its copies into the current batch
+    void
+    CGE_Model_Loader::_record_upload(Pending_Upload& upload) {
+        upload.model = std::make_unique<CGE_Model>(
+            _device,
+            upload.mesh,
+            upload.handle->_vertex_format,
+            &_batcher,
+            _pool);
+
+        // The staging memory holds a copy now, the source geometry can go
+        upload.cached.reset();
+        upload.builder = CGE_Model::Builder{};
+        upload.mesh = CGE_Model::Mesh_View{};
+    }
+
+    void
+    CGE_Model_Loader::_finish_upload(Pending_Upload& upload) {
+        upload.handle->_model = std::move(upload.model);
+        upload.handle->_state.store(CGE_Model_Handle::State::RESIDENT, std::memory_order_release);
+
+        std::cout << "Loaded " << upload.handle->_path << std::endl;
+    }
+
+} // cge
@@ -0,0 +1,473 @@
+#include "cge_obj_loader.hh"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace cge {
+
+    namespace {
+
+        // Face corner as read from one chunk. Negative (relative) indices are
+        // resolved against the chunk-local element count and flagged, so the
+        // merge step can rebase them once the global counts are known
+        struct Raw_Corner {
+            int32_t index[3];   // position, texcoord, normal
+            uint8_t relative;   // bit n set when index[n] is chunk-local
+        };
+
+        struct Chunk {
+            const char* begin;
+            const char* end;
+
+            std::vector<float> positions;
+            std::vector<float> colors;
+            std::vector<float> normals;
+            std::vector<float> texcoords;
+            std::vector<Raw_Corner> corners;
+
+            // element offsets of this chunk in the merged arrays
+            size_t position_base = 0;
+            size_t normal_base = 0;
+            size_t texcoord_base = 0;
+            size_t corner_base = 0;
+
+            std::string error;
+        };
+
+        // Read-only mapping of the whole file, unmapped on scope exit
+        struct File_Mapping {
+            const char* data = nullptr;
+            size_t size = 0;
+
+            ~File_Mapping() {
+                if (data) {
+                    munmap(const_cast<char*>(data), size);
+                }
+            }
+        };
+
+        inline bool is_space(char c) { return c == ' ' || c == '\t'; }
+        inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+        inline const char* skip_spaces(const char* p, const char* end) {
+            while (p < end && is_space(*p)) ++p;
+            return p;
+        }
+
+        // Powers of ten that are exactly representable as doubles
+        constexpr double POW10[] = {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        // Slow path for anything the fast path cannot represent exactly
+        // (very long mantissas, large exponents, inf/nan)
+        const char* parse_float_fallback(const char* p, const char* end, float& out) {
+            char buffer[64];
+            size_t length = 0;
+            while (p + length < end && length < sizeof(buffer) - 1
+                   && !is_space(p[length]) && p[length] != '\r' && p[length] != '\n') {
+                buffer[length] = p[length];
+                length++;
+            }
+            buffer[length] = '\0';
+
+            char* parsed_end = nullptr;
+            out = std::strtof(buffer, &parsed_end);
+            if (parsed_end == buffer) {
+                return nullptr;
+            }
+            return p + (parsed_end - buffer);
+        }
+
+        // Decimal float parser using Clinger's fast path: when the significand
+        // fits in 53 bits and the power of ten is exact, a single double
+        // multiply or divide gives the correctly rounded result
+        const char* parse_float(const char* p, const char* end, float& out) {
+            const char* start = p;
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+')) {
+                negative = *p == '-';
+                ++p;
+            }
+
+            uint64_t mantissa = 0;
+            int exponent = 0;
+            int digits = 0;
+            bool any_digits = false;
+
+            while (p < end && is_digit(*p)) {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    if (mantissa != 0) digits++;
+                } else {
+                    exponent++;
+                }
+                any_digits = true;
+                ++p;
+            }
+
+            if (p < end && *p == '.') {
+                ++p;
+                while (p < end && is_digit(*p)) {
+                    if (digits < 19) {
+                        mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                        if (mantissa != 0) digits++;
+                        exponent--;
+                    }
+                    any_digits = true;
+                    ++p;
+                }
+            }
+
+            if (!any_digits) {
+                return parse_float_fallback(start, end, out);
+            }
+
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                const char* exponent_start = p;
+                ++p;
+                bool exponent_negative = false;
+                if (p < end && (*p == '-' || *p == '+')) {
+                    exponent_negative = *p == '-';
+                    ++p;
+                }
+
+                if (p < end && is_digit(*p)) {
+                    int value = 0;
+                    while (p < end && is_digit(*p)) {
+                        if (value < 10000) value = value * 10 + (*p - '0');
+                        ++p;
+                    }
+                    exponent += exponent_negative ? -value : value;
+                } else {
+                    p = exponent_start;
+                }
+            }
+
+            if (mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+                double value = static_cast<double>(mantissa);
+                value = exponent < 0 ? value / POW10[-exponent] : value * POW10[exponent];
+                out = static_cast<float>(negative ? -value : value);
+                return p;
+            }
+
+            return parse_float_fallback(start, end, out);
+        }
+
+        const char* parse_int(const char* p, const char* end, int32_t& out) {
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+')) {
+                negative = *p == '-';
+                ++p;
+            }
+            if (p >= end || !is_digit(*p)) {
+                return nullptr;
+            }
+
+            int64_t value = 0;
+            while (p < end && is_digit(*p)) {
+                if (value <= INT32_MAX) value = value * 10 + (*p - '0');
+                ++p;
+            }
+            if (value > INT32_MAX) {
+                return nullptr;
+            }
+
+            out = static_cast<int32_t>(negative ? -value : value);
+            return p;
+        }
+
+        // Parse up to max_count floats, returns how many were read
+        int parse_floats(const char* p, const char* end, float* values, int max_count) {
+            int count = 0;
+            while (count < max_count) {
+                p = skip_spaces(p, end);
+                if (p >= end || *p == '\r' || *p == '#') break;
+
+                const char* next = parse_float(p, end, values[count]);
+                if (!next) break;
+                p = next;
+                count++;
+            }
+            return count;
+        }
+
+        // Convert one OBJ face index into a zero-based index.
+        // local_count is the number of elements of that kind seen so far in the chunk
+        bool resolve_index(int32_t value, size_t local_count, int32_t& index, uint8_t& relative, int slot) {
+            if (value > 0) {
+                index = value - 1;
+                return true;
+            }
+            if (value < 0) {
+                index = static_cast<int32_t>(local_count) + value;
+                relative |= static_cast<uint8_t>(1u << slot);
+                return true;
+            }
+            return false;
+        }
+
+        void parse_face(const char* p, const char* end, Chunk& chunk, std::vector<Raw_Corner>& polygon) {
+            polygon.clear();
+
+            size_t position_count = chunk.positions.size() / 3;
+            size_t texcoord_count = chunk.texcoords.size() / 2;
+            size_t normal_count = chunk.normals.size() / 3;
+
+            while (true) {
+                p = skip_spaces(p, end);
+                if (p >= end || *p == '\r' || *p == '#') break;
+
+                Raw_Corner corner{{-1, -1, -1}, 0};
+                int32_t value;
+
+                // v, v/vt, v//vn or v/vt/vn
+                p = parse_int(p, end, value);
+                if (!p || !resolve_index(value, position_count, corner.index[0], corner.relative, 0)) {
+                    throw std::runtime_error("malformed face");
+                }
+
+                if (p < end && *p == '/') {
+                    ++p;
+                    if (p < end && *p != '/') {
+                        p = parse_int(p, end, value);
+                        if (!p || !resolve_index(value, texcoord_count, corner.index[1], corner.relative, 1)) {
+                            throw std::runtime_error("malformed face");
+                        }
+                    }
+                    if (p < end && *p == '/') {
+                        ++p;
+                        p = parse_int(p, end, value);
+                        if (!p || !resolve_index(value, normal_count, corner.index[2], corner.relative, 2)) {
+                            throw std::runtime_error("malformed face");
+                        }
+                    }
+                }
+
+                polygon.push_back(corner);
+
+                // skip anything trailing the index triplet
+                while (p < end && !is_space(*p) && *p != '\r') ++p;
+            }
+
+            // Fan triangulation, polygons are assumed to be convex
+            for (size_t i = 1; i + 1 < polygon.size(); i++) {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[i]);
+                chunk.corners.push_back(polygon[i + 1]);
+            }
+        }
+
+        void parse_chunk(Chunk& chunk) {
+            // Rough per-line byte estimates keep reallocation off the hot path
+            size_t chunk_size = static_cast<size_t>(chunk.end - chunk.begin);
+            chunk.positions.reserve(chunk_size / 16);
+            chunk.colors.reserve(chunk_size / 16);
+            chunk.corners.reserve(chunk_size / 8);
+
+            std::vector<Raw_Corner> polygon;
+            polygon.reserve(8);
+
+            const char* p = chunk.begin;
+            const char* end = chunk.end;
+            size_t line_number = 0;
+
+            try {
+                while (p < end) {
+                    const char* line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+                    if (!line_end) line_end = end;
+                    line_number++;
+
+                    p = skip_spaces(p, line_end);
+                    size_t remaining = static_cast<size_t>(line_end - p);
+
+                    if (remaining >= 2 && p[0] == 'v' && is_space(p[1])) {
+                        // v x y z [r g b]
+                        float values[6] = {0.f, 0.f, 0.f, 1.f, 1.f, 1.f};
+                        int count = parse_floats(p + 2, line_end, values, 6);
+                        if (count < 3) throw std::runtime_error("malformed vertex");
+
+                        chunk.positions.insert(chunk.positions.end(), values, values + 3);
+                        if (count >= 6) {
+                            chunk.colors.insert(chunk.colors.end(), values + 3, values + 6);
+                        } else {
+                            chunk.colors.insert(chunk.colors.end(), {1.f, 1.f, 1.f});
+                        }
+                    } else if (remaining >= 3 && p[0] == 'v' && p[1] == 'n' && is_space(p[2])) {
+                        float values[3] = {};
+                        if (parse_floats(p + 3, line_end, values, 3) < 3) {
+                            throw std::runtime_error("malformed normal");
+                        }
+                        chunk.normals.insert(chunk.normals.end(), values, values + 3);
+                    } else if (remaining >= 3 && p[0] == 'v' && p[1] == 't' && is_space(p[2])) {
+                        float values[3] = {};
+                        if (parse_floats(p + 3, line_end, values, 3) < 1) {
+                            throw std::runtime_error("malformed texcoord");
+                        }
+                        chunk.texcoords.insert(chunk.texcoords.end(), values, values + 2);
+                    } else if (remaining >= 2 && p[0] == 'f' && is_space(p[1])) {
+                        parse_face(p + 2, line_end, chunk, polygon);
+                    }
+
+                    p = line_end + 1;
+                }
+            } catch (const std::exception& e) {
+                chunk.error = std::string(e.what()) + " (chunk line " + std::to_string(line_number) + ")";
+            }
+        }
+
+        bool resolve_corner(const Raw_Corner& raw, const Chunk& chunk, const size_t counts[3], CGE_Obj_Corner& out) {
+            const size_t bases[3] = {chunk.position_base, chunk.texcoord_base, chunk.normal_base};
+            int64_t resolved[3];
+
+            for (int slot = 0; slot < 3; slot++) {
+                int64_t value = raw.index[slot];
+                if (raw.relative & (1u << slot)) {
+                    value += static_cast<int64_t>(bases[slot]);
+                } else if (value < 0) {
+                    resolved[slot] = -1;
+                    continue;
+                }
+
+                if (value < 0 || value >= static_cast<int64_t>(counts[slot])) {
+                    return false;
+                }
+                resolved[slot] = value;
+            }
+
+            out.position = static_cast<int32_t>(resolved[0]);
+            out.texcoord = static_cast<int32_t>(resolved[1]);
+            out.normal = static_cast<int32_t>(resolved[2]);
+            return true;
+        }
+
+        // Copy one chunk into its slice of the merged arrays
+        void merge_chunk(Chunk& chunk, CGE_Obj_Data& out, const size_t counts[3]) {
+            std::copy(chunk.positions.begin(), chunk.positions.end(), out.positions.begin() + chunk.position_base * 3);
+            std::copy(chunk.colors.begin(), chunk.colors.end(), out.colors.begin() + chunk.position_base * 3);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), out.normals.begin() + chunk.normal_base * 3);
+            std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), out.texcoords.begin() + chunk.texcoord_base * 2);
+
+            for (size_t i = 0; i < chunk.corners.size(); i++) {
+                if (!resolve_corner(chunk.corners[i], chunk, counts, out.corners[chunk.corner_base + i])) {
+                    chunk.error = "face references an element that does not exist";
+                    return;
+                }
+            }
+        }
+
+        // Run fn(chunk) for every chunk, one thread per chunk past the first
+        template <typename Fn>
+        void for_each_chunk(std::vector<Chunk>& chunks, Fn fn) {
+            std::vector<std::thread> workers;
+            workers.reserve(chunks.size());
+            for (size_t i = 1; i < chunks.size(); i++) {
+                workers.emplace_back([&chunks, &fn, i]() { fn(chunks[i]); });
+            }
+            fn(chunks[0]);
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+    } // anonymous
+
+    void
+    CGE_Obj_Loader::load(const std::string& filepath, CGE_Obj_Data& out, unsigned thread_count) {
+        out = CGE_Obj_Data{};
+
+        int fd = open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("failed to open file: " + filepath);
+        }
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("failed to stat file: " + filepath);
+        }
+
+        File_Mapping file{};
+        file.size = static_cast<size_t>(st.st_size);
+        if (file.size == 0) {
+            close(fd);
+            return;
+        }
+
+        void* data = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("failed to map file: " + filepath);
+        }
+        file.data = static_cast<const char*>(data);
+        // Advice values are not flags. Chunks are read by several threads at
+        // once, so the file as a whole is not read sequentially
+        madvise(data, file.size, MADV_WILLNEED);
+
+        // Split into line-aligned chunks of at least MIN_CHUNK_SIZE bytes
+        if (thread_count == 0) {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        size_t chunk_count = std::min<size_t>(thread_count, std::max<size_t>(1, file.size / MIN_CHUNK_SIZE));
+        size_t chunk_size = file.size / chunk_count;
+
+        std::vector<Chunk> chunks(chunk_count);
+        const char* file_end = file.data + file.size;
+        const char* cursor = file.data;
+        for (size_t i = 0; i < chunk_count; i++) {
+            const char* chunk_end = file_end;
+            if (i + 1 < chunk_count) {
+                chunk_end = std::min(file_end, cursor + chunk_size);
+                const char* newline = static_cast<const char*>(std::memchr(chunk_end, '\n', file_end - chunk_end));
+                chunk_end = newline ? newline + 1 : file_end;
+            }
+            chunks[i].begin = cursor;
+            chunks[i].end = chunk_end;
+            cursor = chunk_end;
+        }
+
+        for_each_chunk(chunks, parse_chunk);
+        for (const auto& chunk : chunks) {
+            if (!chunk.error.empty()) {
+                throw std::runtime_error(filepath + ": " + chunk.error);
+            }
+        }
+
+        // Prefix sums give each chunk its slice of the merged arrays
+        size_t counts[3] = {0, 0, 0};   // positions, texcoords, normals
+        size_t corner_count = 0;
+        for (auto& chunk : chunks) {
+            chunk.position_base = counts[0];
+            chunk.texcoord_base = counts[1];
+            chunk.normal_base = counts[2];
+            chunk.corner_base = corner_count;
+            counts[0] += chunk.positions.size() / 3;
+            counts[1] += chunk.texcoords.size() / 2;
+            counts[2] += chunk.normals.size() / 3;
+            corner_count += chunk.corners.size();
+        }
+
+        out.positions.resize(counts[0] * 3);
+        out.colors.resize(counts[0] * 3);
+        out.texcoords.resize(counts[1] * 2);
+        out.normals.resize(counts[2] * 3);
+        out.corners.resize(corner_count);
+
+        for_each_chunk(chunks, [&out, &counts](Chunk& chunk) { merge_chunk(chunk, out, counts); });
+        for (const auto& chunk : chunks) {
+            if (!chunk.error.empty()) {
+                throw std::runtime_error(filepath + ": " + chunk.error);
+            }
+        }
+    }
+
+} // cge
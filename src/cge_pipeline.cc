@@ -82,8 +82,8 @@ namespace cge {
         shader_stages[1].pNext = nullptr;
         shader_stages[1].pSpecializationInfo = nullptr;
 
-        auto binding_descriptions = CGE_Model::Vertex::get_binding_description();
-        auto attribute_descriptions = CGE_Model::Vertex::get_attribute_description();
+        auto& binding_descriptions = configInfo._binding_descriptions;
+        auto& attribute_descriptions = configInfo._attribute_descriptions;
         VkPipelineVertexInputStateCreateInfo vertex_input_info{};
         vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());;
@@ -156,6 +156,10 @@ namespace cge {
     CGE_Pipeline::_default_pipeline_config_info(PipelineConfigInfo &config) {
         // PipelineConfigInfo config {};
 
+        /* Vertex Input Configuration -- full precision CGE_Model::Vertex */
+        config._binding_descriptions = CGE_Model::Vertex::get_binding_description();
+        config._attribute_descriptions = CGE_Model::Vertex::get_attribute_description();
+
         config._input_assembly_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         config._input_assembly_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
         config._input_assembly_info.primitiveRestartEnable = VK_FALSE;
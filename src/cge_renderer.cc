@@ -103,6 +103,7 @@ namespace cge {
         }
 
         this->_is_frame_started = true;
+        this->_frame_arena.begin_frame(this->_current_frame_index);
 
         auto command_buffer = this->get_current_command_buffer();
         VkCommandBufferBeginInfo begin_info{};
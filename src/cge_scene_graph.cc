@@ -0,0 +1,275 @@
+#include "cge_scene_graph.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace cge {
+
+    CGE_Scene_Graph::CGE_Scene_Graph(unsigned thread_count)
+        : _thread_count{thread_count ? thread_count : std::max(1u, std::thread::hardware_concurrency())} {
+    }
+
+    CGE_Scene_Graph::~CGE_Scene_Graph() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _work_ready.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    void
+    CGE_Scene_Graph::set_parent(CGE_World& world, CGE_Entity child, CGE_Entity parent) {
+        assert(world.alive(child) && "Child is not alive");
+        assert((!parent.valid() || world.alive(parent)) && "Parent is not alive");
+
+        // Walking up from the new parent must not reach the child
+        for (CGE_Entity ancestor = parent; ancestor.valid(); ancestor = get_parent(ancestor)) {
+            if (ancestor == child) {
+                throw std::runtime_error("Error: scene graph parent is a descendant of the child");
+            }
+        }
+
+        if (parent.valid()) {
+            _join(world, parent);
+        }
+        _join(world, child);
+        _links[child.index].parent = parent;
+        _order_dirty = true;
+    }
+
+    void
+    CGE_Scene_Graph::remove(CGE_World& world, CGE_Entity entity) {
+        if (!contains(entity))
+            return;
+
+        _links[entity.index] = Link{};
+        _member_count--;
+        for (Link& link : _links) {
+            if (link.parent == entity) {
+                link.parent = CGE_Entity{};
+            }
+        }
+        world.remove<WorldTransformComponent>(entity);
+        _order_dirty = true;
+    }
+
+    void
+    CGE_Scene_Graph::_join(CGE_World& world, CGE_Entity entity) {
+        if (contains(entity))
+            return;
+
+        if (entity.index >= _links.size()) {
+            _links.resize(entity.index + 1);
+        }
+        // The slot may still hold an entity destroyed since the last update
+        if (!_links[entity.index].entity.valid()) {
+            _member_count++;
+        }
+        _links[entity.index] = Link{entity, CGE_Entity{}};
+        world.add<WorldTransformComponent>(entity);
+        _order_dirty = true;
+    }
+
+    // Lay the hierarchy out in depth-first order, one root subtree after
+    // the other. Links to parents that left the graph are cleared first
+    void
+    CGE_Scene_Graph::_rebuild() {
+        uint32_t link_count = static_cast<uint32_t>(_links.size());
+        std::vector<uint32_t> first_child(link_count, NO_PARENT);
+        std::vector<uint32_t> next_sibling(link_count, NO_PARENT);
+        for (uint32_t index = link_count; index-- > 0;) {
+            Link& link = _links[index];
+            if (!link.entity.valid())
+                continue;
+            if (link.parent.valid() && !contains(link.parent)) {
+                link.parent = CGE_Entity{};
+            }
+            if (link.parent.valid()) {
+                next_sibling[index] = first_child[link.parent.index];
+                first_child[link.parent.index] = index;
+            }
+        }
+
+        _nodes.clear();
+        _root_starts.clear();
+        std::vector<std::pair<uint32_t, uint32_t>> stack;     // link index, parent position
+        for (uint32_t root = 0; root < link_count; root++) {
+            if (!_links[root].entity.valid() || _links[root].parent.valid())
+                continue;
+
+            _root_starts.push_back(static_cast<uint32_t>(_nodes.size()));
+            stack.push_back({root, NO_PARENT});
+            while (!stack.empty()) {
+                auto [index, parent] = stack.back();
+                stack.pop_back();
+
+                uint32_t position = static_cast<uint32_t>(_nodes.size());
+                _nodes.push_back(Node{_links[index].entity, parent, 0});
+                for (uint32_t child = first_child[index]; child != NO_PARENT; child = next_sibling[child]) {
+                    stack.push_back({child, position});
+                }
+            }
+        }
+        _root_starts.push_back(static_cast<uint32_t>(_nodes.size()));
+        _changed.assign(_nodes.size(), 0);
+    }
+
+    // Runs after any structural change of the world or the graph
+    void
+    CGE_Scene_Graph::_refresh_components(CGE_World& world) {
+        for (Link& link : _links) {
+            if (link.entity.valid() && !world.alive(link.entity)) {
+                link = Link{};
+                _member_count--;
+                _order_dirty = true;
+            }
+        }
+
+        if (_order_dirty) {
+            _rebuild();
+            _split_ranges();
+            _order_dirty = false;
+            _recompute_all = true;
+        }
+
+        // Adding a missing output can move other components, so pointers
+        // are only gathered once every node has one
+        for (const Node& node : _nodes) {
+            if (!world.has<WorldTransformComponent>(node.entity)) {
+                world.add<WorldTransformComponent>(node.entity);
+                _recompute_all = true;
+            }
+        }
+
+        _locals.resize(_nodes.size());
+        _outputs.resize(_nodes.size());
+        for (size_t position = 0; position < _nodes.size(); position++) {
+            _locals[position] = world.get<TransformComponent>(_nodes[position].entity);
+            _outputs[position] = world.get<WorldTransformComponent>(_nodes[position].entity);
+        }
+        _components_version = world.get_structure_version();
+    }
+
+    // Parents precede their children, so a parent's world matrices and
+    // changed flag are final by the time its children are reached
+    uint32_t
+    CGE_Scene_Graph::_update_range(uint32_t begin, uint32_t end) {
+        uint32_t recomputed = 0;
+        for (uint32_t position = begin; position < end; position++) {
+            Node& node = _nodes[position];
+            TransformComponent* local = _locals[position];
+            uint32_t version = local ? local->get_version() : 0;
+
+            bool changed = _recompute_all || version != node.version
+                || (node.parent != NO_PARENT && _changed[node.parent]);
+            _changed[position] = changed;
+            if (!changed)
+                continue;
+
+            // Entities without a transform pass their parent's through
+            WorldTransformComponent& output = *_outputs[position];
+            glm::mat4 matrix{1.f};
+            glm::mat3 normal_matrix{1.f};
+            if (local) {
+                matrix = local->mat4();
+                normal_matrix = local->normalMatrix();
+            }
+            if (node.parent != NO_PARENT) {
+                const WorldTransformComponent& parent = *_outputs[node.parent];
+                matrix = parent.matrix * matrix;
+                normal_matrix = parent.normal_matrix * normal_matrix;
+            }
+            output.matrix = matrix;
+            output.normal_matrix = normal_matrix;
+            node.version = version;
+            recomputed++;
+        }
+        return recomputed;
+    }
+
+    // Ranges end on root boundaries, close to equal node counts. Workers
+    // are started for ranges that have none yet; the workers are idle here,
+    // since updates run on the calling thread and wait for them
+    void
+    CGE_Scene_Graph::_split_ranges() {
+        uint32_t node_count = static_cast<uint32_t>(_nodes.size());
+        uint32_t range_count = std::min(_thread_count, std::max(1u, node_count / MIN_NODES_PER_THREAD));
+
+        _range_bounds.assign(1, 0);
+        for (uint32_t i = 1; i < range_count; i++) {
+            uint32_t target = static_cast<uint32_t>(uint64_t{node_count} * i / range_count);
+            uint32_t bound = *std::lower_bound(_root_starts.begin(), _root_starts.end(), target);
+            if (bound > _range_bounds.back() && bound < node_count) {
+                _range_bounds.push_back(bound);
+            }
+        }
+        _range_bounds.push_back(node_count);
+        _range_recomputed.assign(_range_bounds.size() - 1, 0);
+
+        while (_workers.size() + 1 < _range_recomputed.size()) {
+            uint32_t range = static_cast<uint32_t>(_workers.size() + 1);
+            _workers.emplace_back(&CGE_Scene_Graph::_worker_main, this, range, _dispatch);
+        }
+    }
+
+    // Runs range whenever the dispatch counter moves past the last one seen,
+    // as long as the current split has that many ranges
+    void
+    CGE_Scene_Graph::_worker_main(uint32_t range, uint64_t dispatch) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _work_ready.wait(lock, [this, dispatch] { return _stopping || _dispatch != dispatch; });
+            if (_stopping)
+                return;
+            dispatch = _dispatch;
+            if (range >= _range_recomputed.size())
+                continue;
+
+            lock.unlock();
+            uint32_t recomputed = this->_update_range(_range_bounds[range], _range_bounds[range + 1]);
+            lock.lock();
+
+            _range_recomputed[range] = recomputed;
+            if (--_busy_workers == 0) {
+                _work_done.notify_one();
+            }
+        }
+    }
+
+    uint32_t
+    CGE_Scene_Graph::update(CGE_World& world) {
+        if (_order_dirty || world.get_structure_version() != _components_version) {
+            _refresh_components(world);
+        }
+        if (_nodes.empty())
+            return 0;
+
+        uint32_t range_count = static_cast<uint32_t>(_range_recomputed.size());
+        if (range_count > 1) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _busy_workers = range_count - 1;
+                _dispatch++;
+            }
+            _work_ready.notify_all();
+        }
+
+        _range_recomputed[0] = this->_update_range(_range_bounds[0], _range_bounds[1]);
+
+        if (range_count > 1) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _work_done.wait(lock, [this] { return _busy_workers == 0; });
+        }
+
+        _recompute_all = false;
+        return std::accumulate(_range_recomputed.begin(), _range_recomputed.end(), 0u);
+    }
+
+} // cge
@@ -0,0 +1,75 @@
+#include "cge_staging_ring.hh"
+#include "cge_device.hh"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace cge {
+
+    CGE_Staging_Ring::CGE_Staging_Ring(CGE_Device& device, VkDeviceSize capacity)
+        : _device{device}, _capacity{capacity} {
+        _device.createBuffer(
+            capacity,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            _buffer,
+            _memory);
+        if (!_memory.mapped) {
+            throw std::runtime_error("Error: failed to map staging ring");
+        }
+    }
+
+    CGE_Staging_Ring::~CGE_Staging_Ring() {
+        assert(_head == _tail && "Staging ring destroyed with regions in use");
+        vkDestroyBuffer(_device.device(), _buffer, nullptr);
+        _device.freeMemory(_memory);
+    }
+
+    CGE_Staging_Ring::Region
+    CGE_Staging_Ring::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+        Region region{};
+        if (size == 0 || size > _capacity)
+            return region;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Regions never straddle the end of the buffer; skip to the start
+        // when one would not fit before it
+        uint64_t position = (_head + alignment - 1) & ~(alignment - 1);
+        if (position % _capacity + size > _capacity) {
+            position += _capacity - position % _capacity;
+        }
+        if (position + size - _tail > _capacity)
+            return region;
+
+        region.id = _first_id + _entries.size();
+        _entries.push_back({position + size, false});
+        _head = position + size;
+
+        region.buffer = _buffer;
+        region.offset = position % _capacity;
+        region.size = size;
+        region.data = static_cast<char*>(_memory.mapped) + region.offset;
+        return region;
+    }
+
+    void
+    CGE_Staging_Ring::release(uint64_t id) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        assert(id >= _first_id && id - _first_id < _entries.size() && "Staging region released twice");
+        _entries[id - _first_id].released = true;
+
+        while (!_entries.empty() && _entries.front().released) {
+            _tail = _entries.front().end;
+            _entries.pop_front();
+            _first_id++;
+        }
+    }
+
+    VkDeviceSize
+    CGE_Staging_Ring::get_in_use() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _head - _tail;
+    }
+
+} // cge
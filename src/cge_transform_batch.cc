@@ -0,0 +1,115 @@
+#include "cge_transform_batch.hh"
+#include "cge_transform_simd.hh"
+#include "cge_game_object.hh"
+
+#include <atomic>
+
+namespace cge {
+
+    const char*
+    cge_simd_level_name(CGE_Simd_Level level) {
+        switch (level) {
+            case CGE_Simd_Level::SSE2: return "sse2";
+            case CGE_Simd_Level::AVX2: return "avx2";
+            default:                   return "scalar";
+        }
+    }
+
+    static CGE_Simd_Level detect_simd_level() {
+#ifdef CGE_TRANSFORM_SIMD_X86
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return CGE_Simd_Level::AVX2;
+        }
+#endif
+        // Part of the x86-64 baseline
+        return CGE_Simd_Level::SSE2;
+#else
+        return CGE_Simd_Level::SCALAR;
+#endif
+    }
+
+    CGE_Simd_Level
+    cge_supported_simd_level() {
+        static const CGE_Simd_Level level = detect_simd_level();
+        return level;
+    }
+
+    static std::atomic<CGE_Simd_Level> transform_simd_level{cge_supported_simd_level()};
+
+    CGE_Simd_Level
+    cge_get_transform_simd_level() {
+        return transform_simd_level.load(std::memory_order_relaxed);
+    }
+
+    void
+    cge_set_transform_simd_level(CGE_Simd_Level level) {
+        if (static_cast<uint32_t>(level) > static_cast<uint32_t>(cge_supported_simd_level())) {
+            level = cge_supported_simd_level();
+        }
+        transform_simd_level.store(level, std::memory_order_relaxed);
+    }
+
+    uint32_t
+    _compose_transforms_sse2(
+        const CGE_Transform_SoA& transforms,
+        uint32_t count,
+        glm::mat4* matrices,
+        glm::mat3* normal_matrices
+    ) {
+#ifdef CGE_TRANSFORM_SIMD_X86
+        return compose_transforms<Simd_SSE2>(transforms, count, matrices, normal_matrices);
+#else
+        (void)transforms;
+        (void)count;
+        (void)matrices;
+        (void)normal_matrices;
+        return 0;
+#endif
+    }
+
+    static CGE_Transform_SoA offset_transforms(const CGE_Transform_SoA& transforms, uint32_t offset) {
+        CGE_Transform_SoA result{};
+        for (int axis = 0; axis < 3; axis++) {
+            result.translation[axis] = transforms.translation[axis] + offset;
+            result.rotation[axis] = transforms.rotation[axis] + offset;
+            result.scale[axis] = transforms.scale[axis] + offset;
+        }
+        return result;
+    }
+
+    void
+    cge_compose_transforms(
+        const CGE_Transform_SoA& transforms,
+        uint32_t count,
+        glm::mat4* matrices,
+        glm::mat3* normal_matrices
+    ) {
+        uint32_t done = 0;
+        switch (cge_get_transform_simd_level()) {
+            case CGE_Simd_Level::AVX2:
+                done = _compose_transforms_avx2(transforms, count, matrices, normal_matrices);
+                // The last 4 to 7 still fit the SSE2 path
+                done += _compose_transforms_sse2(
+                    offset_transforms(transforms, done), count - done, matrices + done, normal_matrices + done);
+                break;
+            case CGE_Simd_Level::SSE2:
+                done = _compose_transforms_sse2(transforms, count, matrices, normal_matrices);
+                break;
+            default:
+                break;
+        }
+
+        // Whatever is left is less than one vector wide
+        for (uint32_t i = done; i < count; i++) {
+            TransformComponent::compose(
+                {transforms.translation[0][i], transforms.translation[1][i], transforms.translation[2][i]},
+                {transforms.scale[0][i], transforms.scale[1][i], transforms.scale[2][i]},
+                {transforms.rotation[0][i], transforms.rotation[1][i], transforms.rotation[2][i]},
+                matrices[i],
+                normal_matrices[i]);
+        }
+    }
+
+} // cge
@@ -0,0 +1,25 @@
+// Built with -mavx2 -mfma (see the Makefile). Only called after
+// cge_supported_simd_level() found both on the CPU
+#include "cge_transform_simd.hh"
+
+namespace cge {
+
+    uint32_t
+    _compose_transforms_avx2(
+        const CGE_Transform_SoA& transforms,
+        uint32_t count,
+        glm::mat4* matrices,
+        glm::mat3* normal_matrices
+    ) {
+#if defined(CGE_TRANSFORM_SIMD_X86) && defined(__AVX2__) && defined(__FMA__)
+        return compose_transforms<Simd_AVX2>(transforms, count, matrices, normal_matrices);
+#else
+        (void)transforms;
+        (void)count;
+        (void)matrices;
+        (void)normal_matrices;
+        return 0;
+#endif
+    }
+
+} // cge
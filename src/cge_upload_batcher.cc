@@ -0,0 +1,353 @@
+#include "cge_upload_batcher.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace cge {
+
+    // Copies are placed at this alignment in the ring or a staging chunk, which
+    // covers every vertex and index element size
+    static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+    static VkCommandPool create_command_pool(CGE_Device& device, uint32_t queue_family) {
+        VkCommandPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_info.queueFamilyIndex = queue_family;
+        pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        VkCommandPool pool;
+        if (vkCreateCommandPool(device.device(), &pool_info, nullptr, &pool) != VK_SUCCESS) {
+            throw std::runtime_error("Error: failed to create upload command pool");
+        }
+        return pool;
+    }
+
+    static VkCommandBuffer allocate_command_buffer(CGE_Device& device, VkCommandPool pool) {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandPool = pool;
+        alloc_info.commandBufferCount = 1;
+
+        VkCommandBuffer command_buffer;
+        if (vkAllocateCommandBuffers(device.device(), &alloc_info, &command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Error: failed to allocate upload command buffer");
+        }
+        return command_buffer;
+    }
+
+    static VkFence create_fence(CGE_Device& device) {
+        VkFenceCreateInfo fence_info{};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        VkFence fence;
+        if (vkCreateFence(device.device(), &fence_info, nullptr, &fence) != VK_SUCCESS) {
+            throw std::runtime_error("Error: failed to create upload fence");
+        }
+        return fence;
+    }
+
+    static void begin_one_time(VkCommandBuffer command_buffer) {
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(command_buffer, &begin_info);
+    }
+
+    CGE_Upload_Batcher::CGE_Upload_Batcher(CGE_Device& device) : _device{device} {
+        _graphics_family = _device.findPhysicalQueueFamilies().graphicsFamily;
+        _command_pool = create_command_pool(_device, _device.transferQueueFamily());
+        if (_device.hasSeparateTransferQueue()) {
+            _acquire_pool = create_command_pool(_device, _graphics_family);
+        }
+    }
+
+    CGE_Upload_Batcher::~CGE_Upload_Batcher() {
+        this->flush();
+
+        for (auto& batch : _free_batches) {
+            vkDestroyFence(_device.device(), batch->fence, nullptr);
+            if (_transfer_ownership()) {
+                vkDestroyFence(_device.device(), batch->acquire_fence, nullptr);
+                vkDestroySemaphore(_device.device(), batch->transferred, nullptr);
+            }
+        }
+        // Destroying the pools frees every command buffer allocated from them
+        vkDestroyCommandPool(_device.device(), _command_pool, nullptr);
+        if (_transfer_ownership()) {
+            vkDestroyCommandPool(_device.device(), _acquire_pool, nullptr);
+        }
+    }
+
+    // Open a batch for recording, reusing a spent one when possible
+    void
+    CGE_Upload_Batcher::_begin_batch() {
+        if (!_free_batches.empty()) {
+            _recording = std::move(_free_batches.back());
+            _free_batches.pop_back();
+            vkResetCommandBuffer(_recording->command_buffer, 0);
+        } else {
+            _recording = std::make_unique<Batch>();
+            _recording->command_buffer = allocate_command_buffer(_device, _command_pool);
+            _recording->fence = create_fence(_device);
+
+            if (_transfer_ownership()) {
+                _recording->acquire_command_buffer = allocate_command_buffer(_device, _acquire_pool);
+                _recording->acquire_fence = create_fence(_device);
+
+                VkSemaphoreCreateInfo semaphore_info{};
+                semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+                if (vkCreateSemaphore(_device.device(), &semaphore_info, nullptr, &_recording->transferred) != VK_SUCCESS) {
+                    throw std::runtime_error("Error: failed to create upload semaphore");
+                }
+            }
+        }
+
+        _recording->id = _next_batch++;
+        begin_one_time(_recording->command_buffer);
+
+        _chunk_offset = 0;
+        _recorded_bytes = 0;
+    }
+
+    void
+    CGE_Upload_Batcher::upload(VkBuffer dst, const void* data, VkDeviceSize size, VkDeviceSize dst_offset) {
+        if (size == 0)
+            return;
+
+        if (!_recording) {
+            this->_begin_batch();
+        }
+
+        // Stage in the device's ring, reclaiming finished batches once before
+        // falling back to a temporary chunk. Copies larger than half the ring
+        // would stall it, so they always get a chunk
+        CGE_Staging_Ring& ring = _device.stagingRing();
+        CGE_Staging_Ring::Region region{};
+        if (size <= ring.get_capacity() / 2) {
+            region = ring.allocate(size, STAGING_ALIGNMENT);
+            if (!region.valid() && !_in_flight.empty()) {
+                this->collect();
+                region = ring.allocate(size, STAGING_ALIGNMENT);
+            }
+        }
+
+        VkBuffer src;
+        VkDeviceSize src_offset;
+        if (region.valid()) {
+            std::memcpy(region.data, data, size);
+            _recording->ring_regions.push_back(region.id);
+            src = region.buffer;
+            src_offset = region.offset;
+        } else {
+            // Sub-allocate from the current chunk, starting a new one when full
+            VkDeviceSize offset = (_chunk_offset + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+            auto& staging = _recording->staging;
+            if (staging.empty() || offset + size > staging.back()->get_buffer_size()) {
+                staging.push_back(std::make_unique<CGE_Buffer>(
+                    _device,
+                    std::max(size, STAGING_CHUNK_SIZE),
+                    1,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                ));
+                staging.back()->map();
+                offset = 0;
+            }
+
+            CGE_Buffer& chunk = *staging.back();
+            std::memcpy(static_cast<char*>(chunk.get_mapped_memory()) + offset, data, size);
+            _chunk_offset = offset + size;
+            src = chunk.get_buffer();
+            src_offset = offset;
+        }
+
+        VkBufferCopy copy_region{};
+        copy_region.srcOffset = src_offset;
+        copy_region.dstOffset = dst_offset;
+        copy_region.size = size;
+        vkCmdCopyBuffer(_recording->command_buffer, src, dst, 1, &copy_region);
+
+        if (_transfer_ownership()) {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = _device.transferQueueFamily();
+            barrier.dstQueueFamilyIndex = _graphics_family;
+            barrier.buffer = dst;
+            barrier.offset = dst_offset;
+            barrier.size = size;
+            _recording->ownership.push_back(barrier);
+        }
+
+        _recorded_bytes += size;
+        _device.memoryAllocator().record_upload(size, false);
+    }
+
+    uint64_t
+    CGE_Upload_Batcher::submit() {
+        if (!_recording)
+            return _next_batch - 1;
+
+        Batch& batch = *_recording;
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &batch.command_buffer;
+
+        if (_transfer_ownership()) {
+            // Release half of the queue family ownership transfer
+            for (auto& barrier : batch.ownership) {
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0;
+            }
+            vkCmdPipelineBarrier(
+                batch.command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0, nullptr,
+                static_cast<uint32_t>(batch.ownership.size()), batch.ownership.data(),
+                0, nullptr);
+
+            submit_info.signalSemaphoreCount = 1;
+            submit_info.pSignalSemaphores = &batch.transferred;
+        } else {
+            // Make the copies visible to whatever reads the buffers next
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            vkCmdPipelineBarrier(
+                batch.command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr);
+        }
+
+        if (vkEndCommandBuffer(batch.command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Error: failed to record upload command buffer");
+        }
+
+        if (vkQueueSubmit(_device.transferQueue(), 1, &submit_info, batch.fence) != VK_SUCCESS) {
+            throw std::runtime_error("Error: failed to submit upload batch");
+        }
+
+        uint64_t id = batch.id;
+        _in_flight.push_back(std::move(_recording));
+        _recorded_bytes = 0;
+        return id;
+    }
+
+    // Acquire half of the ownership transfer, on the graphics queue. The
+    // semaphore is already signaled by the time this is submitted
+    void
+    CGE_Upload_Batcher::_submit_acquire(Batch& batch) {
+        for (auto& barrier : batch.ownership) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        }
+
+        vkResetCommandBuffer(batch.acquire_command_buffer, 0);
+        begin_one_time(batch.acquire_command_buffer);
+        vkCmdPipelineBarrier(
+            batch.acquire_command_buffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            0, nullptr,
+            static_cast<uint32_t>(batch.ownership.size()), batch.ownership.data(),
+            0, nullptr);
+        if (vkEndCommandBuffer(batch.acquire_command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Error: failed to record upload acquire command buffer");
+        }
+
+        VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.waitSemaphoreCount = 1;
+        submit_info.pWaitSemaphores = &batch.transferred;
+        submit_info.pWaitDstStageMask = &wait_stage;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &batch.acquire_command_buffer;
+
+        if (vkQueueSubmit(_device.graphicsQueue(), 1, &submit_info, batch.acquire_fence) != VK_SUCCESS) {
+            throw std::runtime_error("Error: failed to submit upload acquire");
+        }
+        batch.acquire_submitted = true;
+    }
+
+    // Fence that signals once the batch is usable by the graphics queue
+    VkFence
+    CGE_Upload_Batcher::_completion_fence(const Batch& batch) const {
+        return _transfer_ownership() ? batch.acquire_fence : batch.fence;
+    }
+
+    void
+    CGE_Upload_Batcher::_release_batch(std::unique_ptr<Batch> batch) {
+        _completed_batch = batch->id;
+        for (uint64_t region : batch->ring_regions) {
+            _device.stagingRing().release(region);
+        }
+        batch->ring_regions.clear();
+        batch->staging.clear();
+        batch->ownership.clear();
+        batch->acquire_submitted = false;
+
+        vkResetFences(_device.device(), 1, &batch->fence);
+        if (_transfer_ownership()) {
+            vkResetFences(_device.device(), 1, &batch->acquire_fence);
+        }
+        _free_batches.push_back(std::move(batch));
+    }
+
+    // Fences of separate submits are not ordered, so batches are retired
+    // front to back and is_complete never reports a batch ahead of an older one
+    void
+    CGE_Upload_Batcher::collect() {
+        if (_transfer_ownership()) {
+            for (auto& batch : _in_flight) {
+                if (!batch->acquire_submitted
+                    && vkGetFenceStatus(_device.device(), batch->fence) == VK_SUCCESS) {
+                    this->_submit_acquire(*batch);
+                }
+            }
+        }
+
+        while (!_in_flight.empty() && _in_flight.front()->acquire_submitted == _transfer_ownership()
+               && vkGetFenceStatus(_device.device(), this->_completion_fence(*_in_flight.front())) == VK_SUCCESS) {
+            this->_release_batch(std::move(_in_flight.front()));
+            _in_flight.pop_front();
+        }
+    }
+
+    bool
+    CGE_Upload_Batcher::is_complete(uint64_t batch) {
+        if (batch > _completed_batch) {
+            this->collect();
+        }
+        return batch <= _completed_batch;
+    }
+
+    void
+    CGE_Upload_Batcher::flush() {
+        this->submit();
+
+        while (!_in_flight.empty()) {
+            Batch& batch = *_in_flight.front();
+            if (_transfer_ownership() && !batch.acquire_submitted) {
+                vkWaitForFences(_device.device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+                this->_submit_acquire(batch);
+            }
+
+            VkFence fence = this->_completion_fence(batch);
+            vkWaitForFences(_device.device(), 1, &fence, VK_TRUE, UINT64_MAX);
+            this->_release_batch(std::move(_in_flight.front()));
+            _in_flight.pop_front();
+        }
+    }
+
+} // cge
@@ -0,0 +1,102 @@
+#include "cge_vertex_format.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace cge {
+
+    uint16_t
+    cge_pack_half(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000u;
+        uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+        // NaN stays a quiet NaN, infinity and overflow become infinity
+        if (magnitude >= 0x7F800000u) {
+            return static_cast<uint16_t>(sign | (magnitude > 0x7F800000u ? 0x7E00u : 0x7C00u));
+        }
+        if (magnitude >= 0x477FF000u) {
+            return static_cast<uint16_t>(sign | 0x7C00u);
+        }
+
+        // Subnormal half: let the FPU do the rounding by adding 0.5, which
+        // lines the mantissa up with the half's subnormal spacing
+        if (magnitude < 0x38800000u) {
+            float f;
+            std::memcpy(&f, &magnitude, sizeof(f));
+            f += 0.5f;
+            uint32_t rounded;
+            std::memcpy(&rounded, &f, sizeof(rounded));
+            return static_cast<uint16_t>(sign | (rounded - 0x3F000000u));
+        }
+
+        // Normal half: rebias the exponent and round the mantissa to nearest even
+        uint32_t odd = (magnitude >> 13) & 1u;
+        magnitude += 0xC8000FFFu + odd;
+        return static_cast<uint16_t>(sign | (magnitude >> 13));
+    }
+
+    float
+    cge_unpack_half(uint16_t value) {
+        uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+        uint32_t exponent = (value >> 10) & 0x1Fu;
+        uint32_t mantissa = value & 0x3FFu;
+
+        uint32_t bits;
+        if (exponent == 0x1F) {
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        } else if (exponent != 0) {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        } else {
+            float f = static_cast<float>(mantissa) * (1.f / 16777216.f);
+            std::memcpy(&bits, &f, sizeof(bits));
+            bits |= sign;
+        }
+
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    int16_t
+    cge_pack_snorm16(float value) {
+        float clamped = std::min(std::max(value, -1.f), 1.f);
+        return static_cast<int16_t>(std::lround(clamped * 32767.f));
+    }
+
+    uint8_t
+    cge_pack_unorm8(float value) {
+        float clamped = std::min(std::max(value, 0.f), 1.f);
+        return static_cast<uint8_t>(std::lround(clamped * 255.f));
+    }
+
+    glm::vec2
+    cge_encode_octahedral(glm::vec3 normal) {
+        float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+        if (sum == 0.f) {
+            return glm::vec2{0.f};
+        }
+
+        glm::vec2 p{normal.x / sum, normal.y / sum};
+        if (normal.z < 0.f) {
+            // Fold the lower hemisphere over the diagonals
+            p = glm::vec2{
+                (1.f - std::fabs(p.y)) * (p.x >= 0.f ? 1.f : -1.f),
+                (1.f - std::fabs(p.x)) * (p.y >= 0.f ? 1.f : -1.f)};
+        }
+        return p;
+    }
+
+    glm::vec3
+    cge_decode_octahedral(glm::vec2 encoded) {
+        glm::vec3 normal{encoded.x, encoded.y, 1.f - std::fabs(encoded.x) - std::fabs(encoded.y)};
+        float t = std::max(-normal.z, 0.f);
+        normal.x += normal.x >= 0.f ? -t : t;
+        normal.y += normal.y >= 0.f ? -t : t;
+        return glm::normalize(normal);
+    }
+
+} // cge
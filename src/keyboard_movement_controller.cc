@@ -7,36 +7,61 @@ namespace cge {
     KeyboardMovementController::move_in_plane_xz(
         GLFWwindow* window, 
         float dt, 
-        CGE_Game_Object& game_object
+        TransformComponent& transform
     ) {
-        glm::vec3 rotate{0};
-        if (glfwGetKey(window, keys.look_right) == GLFW_PRESS) rotate.y += 1.f;
-        if (glfwGetKey(window, keys.look_left) == GLFW_PRESS)  rotate.y -= 1.f;
-        if (glfwGetKey(window, keys.look_up) == GLFW_PRESS) rotate.x += 1.f;
-        if (glfwGetKey(window, keys.look_down) == GLFW_PRESS)  rotate.x -= 1.f;
-   
-        if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
-            game_object.transform.rotation += look_speed * dt * glm::normalize(rotate);
+        this->_apply(this->_read_input(window), dt, transform);
+    }
+
+    void
+    KeyboardMovementController::update(GLFWwindow* window, float dt, CGE_World& world) {
+        Input input = this->_read_input(window);
+        world.each_chunk<TransformComponent, KeyboardControlComponent>(
+            [&](uint32_t count, const CGE_Entity*, TransformComponent* transforms, KeyboardControlComponent*) {
+                for (uint32_t i = 0; i < count; i++) {
+                    this->_apply(input, dt, transforms[i]);
+                }
+            });
+    }
+
+    KeyboardMovementController::Input
+    KeyboardMovementController::_read_input(GLFWwindow* window) const {
+        Input input{};
+        if (glfwGetKey(window, keys.look_right) == GLFW_PRESS) input.rotate.y += 1.f;
+        if (glfwGetKey(window, keys.look_left) == GLFW_PRESS)  input.rotate.y -= 1.f;
+        if (glfwGetKey(window, keys.look_up) == GLFW_PRESS) input.rotate.x += 1.f;
+        if (glfwGetKey(window, keys.look_down) == GLFW_PRESS)  input.rotate.x -= 1.f;
+
+        if (glfwGetKey(window, keys.move_forward) == GLFW_PRESS) input.move.x += 1.f;
+        if (glfwGetKey(window, keys.move_backward) == GLFW_PRESS) input.move.x -= 1.f;
+        if (glfwGetKey(window, keys.move_right) == GLFW_PRESS) input.move.y += 1.f;
+        if (glfwGetKey(window, keys.move_left) == GLFW_PRESS) input.move.y -= 1.f;
+        if (glfwGetKey(window, keys.move_up) == GLFW_PRESS) input.move.z += 1.f;
+        if (glfwGetKey(window, keys.move_down) == GLFW_PRESS) input.move.z -= 1.f;
+        return input;
+    }
+
+    void
+    KeyboardMovementController::_apply(const Input& input, float dt, TransformComponent& transform) const {
+        // Unchanged values do not invalidate the cached matrices, so idle
+        // entities stay clean
+        glm::vec3 rotation = transform.get_rotation();
+        if (glm::dot(input.rotate, input.rotate) > std::numeric_limits<float>::epsilon()) {
+            rotation += look_speed * dt * glm::normalize(input.rotate);
         }
 
-        game_object.transform.rotation.x = glm::clamp(game_object.transform.rotation.x, -1.5f, 1.5f);
-        game_object.transform.rotation.y = glm::mod(game_object.transform.rotation.y, glm::two_pi<float>());
+        rotation.x = glm::clamp(rotation.x, -1.5f, 1.5f);
+        rotation.y = glm::mod(rotation.y, glm::two_pi<float>());
+        transform.set_rotation(rotation);
         
-        float yaw = game_object.transform.rotation.y;
+        float yaw = rotation.y;
         const glm::vec3 forward_dir{sin(yaw), 0.f, cos(yaw)};
         const glm::vec3 right_dir{forward_dir.z, 0.f, -forward_dir.x};
         const glm::vec3 up_dir{0.f, -1.f, 0.f};
 
-        glm::vec3 move_dir{0.f};
-        if (glfwGetKey(window, keys.move_forward) == GLFW_PRESS) move_dir += forward_dir;
-        if (glfwGetKey(window, keys.move_backward) == GLFW_PRESS) move_dir -= forward_dir;
-        if (glfwGetKey(window, keys.move_right) == GLFW_PRESS) move_dir += right_dir;
-        if (glfwGetKey(window, keys.move_left) == GLFW_PRESS) move_dir -= right_dir;
-        if (glfwGetKey(window, keys.move_up) == GLFW_PRESS) move_dir += up_dir;
-        if (glfwGetKey(window, keys.move_down) == GLFW_PRESS) move_dir -= up_dir;
+        glm::vec3 move_dir = input.move.x * forward_dir + input.move.y * right_dir + input.move.z * up_dir;
 
         if (glm::dot(move_dir, move_dir) > std::numeric_limits<float>::epsilon()) {
-            game_object.transform.translation += move_speed * dt * glm::normalize(move_dir);
+            transform.translate(move_speed * dt * glm::normalize(move_dir));
         }
     }
 }
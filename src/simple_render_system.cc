@@ -1,8 +1,11 @@
 #include "simple_render_system.hh"
 #include "cge_game_object.hh"
+#include "cge_scene_graph.hh"
 #include "cge_model.hh"
 #include "cge_pipeline.hh"
 #include "cge_swap_chain.hh"
+#include "cge_meshlet.hh"
+#include "cge_model_loader.hh"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_PATTERN_ZERO_TO_ONE
@@ -12,6 +15,9 @@
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -27,12 +33,29 @@ namespace cge {
         glm::mat4 normalMatrix{1.f};
     };
 
+    // Layout of the push block in shaders/vert/pulling.vert. The normal
+    // matrix is cut to three columns to make room for the vertex address
+    // within the 128 bytes every device supports
+    struct PullingPushConstantData {
+        glm::mat4 transform{1.f};
+        glm::vec4 normalMatrix[3]{};
+        VkDeviceAddress vertices = 0;
+        uint32_t format = 0;
+        uint32_t stride = 0;       // in 32-bit words
+    };
+
+    static_assert(sizeof(PullingPushConstantData) == 128, "PullingPushConstantData must match pulling.vert");
+
     //
     // CONSTRUCTOR
     //
     SimpleRenderSystem::SimpleRenderSystem(CGE_Device &device, VkRenderPass render_pass) : _device{device} {
         this->_create_pipeline_layout();
         this->_create_pipeline(render_pass);
+        if (device.bufferDeviceAddressSupported()) {
+            this->_create_pulling_pipeline(render_pass);
+        }
+        this->_create_placeholder_model();
     }
 
     //
@@ -40,6 +63,9 @@ namespace cge {
     //
     SimpleRenderSystem::~SimpleRenderSystem() {
         vkDestroyPipelineLayout(this->_device.device(), this->_pipeline_layout, nullptr);
+        if (this->_pulling_pipeline_layout != VK_NULL_HANDLE) {
+            vkDestroyPipelineLayout(this->_device.device(), this->_pulling_pipeline_layout, nullptr);
+        }
     }
 
     //
@@ -71,47 +97,340 @@ namespace cge {
         }
     }
 
+    //
+    // Create the box drawn in place of models that are still loading
+    //
+    void
+    SimpleRenderSystem::_create_placeholder_model() {
+        CGE_Model::Builder builder{};
+        for (uint32_t i = 0; i < 8; i++) {
+            CGE_Model::Vertex vertex{};
+            vertex.position = glm::vec3{
+                (i & 1) ? .5f : -.5f,
+                (i & 2) ? .5f : -.5f,
+                (i & 4) ? .5f : -.5f};
+            vertex.color = glm::vec3{.5f, .5f, .5f};
+            vertex.normals = glm::normalize(vertex.position);
+            builder.vertices.push_back(vertex);
+        }
+        builder.indices = {
+            0, 2, 1, 1, 2, 3,   // -z
+            4, 5, 6, 5, 7, 6,   // +z
+            0, 1, 4, 1, 5, 4,   // -y
+            2, 6, 3, 3, 6, 7,   // +y
+            0, 4, 2, 2, 4, 6,   // -x
+            1, 3, 5, 3, 7, 5};  // +x
+
+        this->_placeholder_model = std::make_unique<CGE_Model>(this->_device, builder);
+    }
+
+    //
+    // Swap in streamed models that became resident. Returns the model to draw
+    // this frame, which is the placeholder box while the real one is loading,
+    // or nullptr. Once the worker has parsed the model, model_matrix is
+    // stretched over its bounds; before that the worker may still be writing
+    // them, so the unit box is drawn as is
+    //
+    CGE_Model*
+    SimpleRenderSystem::_resolve_model(ModelComponent& component, glm::mat4& model_matrix) const {
+        if (component.pending_model) {
+            if (component.pending_model->is_resident()) {
+                component.model = component.pending_model->get_model();
+                component.pending_model.reset();
+                component.lod = 0;
+            } else if (component.pending_model->get_state() == CGE_Model_Handle::State::FAILED) {
+                component.pending_model.reset();
+            } else if (!component.pending_model->has_bounds()) {
+                return this->_placeholder_model.get();
+            } else {
+                glm::vec3 bounds_min = component.pending_model->get_bounds_min();
+                glm::vec3 bounds_max = component.pending_model->get_bounds_max();
+                glm::mat4 box{1.f};
+                box[0][0] = std::max(bounds_max.x - bounds_min.x, 1e-4f);
+                box[1][1] = std::max(bounds_max.y - bounds_min.y, 1e-4f);
+                box[2][2] = std::max(bounds_max.z - bounds_min.z, 1e-4f);
+                box[3] = glm::vec4((bounds_min + bounds_max) * 0.5f, 1.f);
+                model_matrix = model_matrix * box;
+                return this->_placeholder_model.get();
+            }
+        }
+        return component.model.get();
+    }
+
+    //
+    // Pick the coarsest level whose simplification error projects below the
+    // threshold, moving at most across the hysteresis band from last frame
+    //
+    uint32_t
+    SimpleRenderSystem::_select_lod(ModelComponent& component, const glm::mat4& model_matrix, const CGE_Camera& camera) const {
+        const auto& lods = component.model->get_lods();
+        if (lods.size() <= 1) {
+            component.lod = 0;
+            return 0;
+        }
+
+        // World space scale of the bounds is the longest transformed axis
+        float scale = std::max({
+            glm::length(glm::vec3(model_matrix[0])),
+            glm::length(glm::vec3(model_matrix[1])),
+            glm::length(glm::vec3(model_matrix[2]))});
+
+        glm::vec4 center = camera.get_view_matrix() * model_matrix * glm::vec4(component.model->get_bounds_center(), 1.f);
+        float distance = glm::length(glm::vec3(center));
+        if (distance <= component.model->get_bounds_radius() * scale) {
+            component.lod = 0;
+            return 0;
+        }
+
+        // Object space error to a fraction of the viewport half height
+        float error_to_screen = scale * std::fabs(camera.get_projection_matrix()[1][1]) / distance;
+        auto projected_error = [&](uint32_t level) { return lods[level].error * error_to_screen; };
+
+        uint32_t lod = std::min<uint32_t>(component.lod, static_cast<uint32_t>(lods.size() - 1));
+        while (lod > 0 && projected_error(lod) > this->_lod_threshold * (1.f + LOD_HYSTERESIS)) {
+            lod--;
+        }
+        while (lod + 1 < lods.size() && projected_error(lod + 1) <= this->_lod_threshold * (1.f - LOD_HYSTERESIS)) {
+            lod++;
+        }
+
+        component.lod = lod;
+        return lod;
+    }
+
     void
     SimpleRenderSystem::render_game_objects(
             FrameInfo &frame_info,
-            std::vector<CGE_Game_Object>& game_objects) {
-        this->_pipeline->_bind(frame_info.command_buffer);
-
+            CGE_World& world) {
         auto projection_view = frame_info.camera.get_projection_matrix() * frame_info.camera.get_view_matrix();
 
-        for (auto& obj: game_objects) {
-            SimplePushConstantData push{};
-            auto model_matrix = obj.transform.mat4();
-            push.transform = projection_view * model_matrix;
-            push.normalMatrix = obj.transform.normalMatrix();
-
-            vkCmdPushConstants(
-                frame_info.command_buffer, 
-                this->_pipeline_layout, 
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 
-                0, 
-                sizeof(SimplePushConstantData), 
-                &push
-            );
-            obj.model->_bind(frame_info.command_buffer);
-            obj.model->_draw(frame_info.command_buffer);
+        // Build the draw list in frame scratch memory, sorted by vertex
+        // format and then geometry so each pipeline and each geometry pool
+        // or model is bound once per run of draws
+        struct Draw {
+            uint32_t format;
+            const void* geometry;
+            const glm::mat3* normal_matrix;
+            ModelComponent* component;
+            CGE_Model* model;
+            glm::mat4 model_matrix;
+        };
+        CGE_Frame_Vector<Draw> draws{CGE_Arena_Allocator<Draw>(frame_info.frame_arena)};
+        draws.reserve(world.count<TransformComponent, ModelComponent>());
+
+        // Only the transform and model arrays are read; component pointers
+        // stay valid because nothing changes the world while drawing.
+        // Entities in the scene graph draw with their world matrices
+        world.each_chunk<TransformComponent, ModelComponent>(
+            [&](uint32_t count, const CGE_Entity* entities, TransformComponent* transforms, ModelComponent* components) {
+                WorldTransformComponent* world_transforms = world.optional_column<WorldTransformComponent>(entities);
+                if (!world_transforms) {
+                    TransformComponent::update_matrices(transforms, count);
+                }
+                for (uint32_t i = 0; i < count; i++) {
+                    glm::mat4 model_matrix = world_transforms ? world_transforms[i].matrix : transforms[i].mat4();
+                    const glm::mat3* normal_matrix = world_transforms
+                        ? &world_transforms[i].normal_matrix
+                        : &transforms[i].normalMatrix();
+                    CGE_Model* model = this->_resolve_model(components[i], model_matrix);
+                    if (!model)
+                        continue;
+
+                    const void* geometry = model->get_geometry_pool()
+                        ? static_cast<const void*>(model->get_geometry_pool())
+                        : static_cast<const void*>(model);
+                    draws.push_back({
+                        static_cast<uint32_t>(model->get_vertex_format()),
+                        geometry,
+                        normal_matrix,
+                        &components[i],
+                        model,
+                        model_matrix});
+                }
+            });
+
+        std::sort(draws.begin(), draws.end(), [](const Draw& a, const Draw& b) {
+            if (a.format != b.format)
+                return a.format < b.format;
+            return std::less<const void*>()(a.geometry, b.geometry);
+        });
+
+        bool pulling = this->uses_vertex_pulling();
+        CGE_Pipeline* bound_pipeline = nullptr;
+        const void* bound_geometry = nullptr;
+
+        for (auto& draw : draws) {
+            CGE_Model* model = draw.model;
+            const glm::mat4& model_matrix = draw.model_matrix;
+
+            CGE_Pipeline* pipeline = pulling ? this->_pulling_pipeline.get() : this->_pipelines[draw.format].get();
+            if (pipeline != bound_pipeline) {
+                pipeline->_bind(frame_info.command_buffer);
+                bound_pipeline = pipeline;
+            }
+
+            // Packed positions are dequantized by folding the model's
+            // dequantization matrix into the transform
+            glm::mat4 transform = projection_view * model_matrix * model->get_dequantization();
+            glm::mat4 normal_matrix{*draw.normal_matrix};
+
+            if (pulling) {
+                PullingPushConstantData push{};
+                push.transform = transform;
+                for (int column = 0; column < 3; column++) {
+                    push.normalMatrix[column] = normal_matrix[column];
+                }
+                push.vertices = model->get_vertex_address();
+                push.format = draw.format;
+                push.stride = model->get_vertex_stride() / sizeof(uint32_t);
+
+                vkCmdPushConstants(
+                    frame_info.command_buffer,
+                    this->_pulling_pipeline_layout,
+                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                    0,
+                    sizeof(PullingPushConstantData),
+                    &push
+                );
+            } else {
+                SimplePushConstantData push{};
+                push.transform = transform;
+                push.normalMatrix = normal_matrix;
+
+                vkCmdPushConstants(
+                    frame_info.command_buffer, 
+                    this->_pipeline_layout, 
+                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 
+                    0, 
+                    sizeof(SimplePushConstantData), 
+                    &push
+                );
+            }
+
+            // Vertex pulling only needs the index buffer, which pooled
+            // models share
+            if (draw.geometry != bound_geometry) {
+                if (pulling) {
+                    model->_bind_indices(frame_info.command_buffer);
+                } else {
+                    model->_bind(frame_info.command_buffer);
+                }
+                bound_geometry = draw.geometry;
+            }
+
+            if (model == this->_placeholder_model.get()) {
+                model->_draw(frame_info.command_buffer);
+                continue;
+            }
+
+            uint32_t lod = this->_select_lod(*draw.component, model_matrix, frame_info.camera);
+            uint32_t first_meshlet = 0;
+            uint32_t meshlet_count = 0;
+            if (!model->get_lods().empty()) {
+                first_meshlet = model->get_lods()[lod].first_meshlet;
+                meshlet_count = model->get_lods()[lod].meshlet_count;
+            }
+
+            // Cull meshlets in object space: the frustum planes come from the
+            // full transform and the camera is moved into the model's frame.
+            // Objects whose commands no longer fit in the frame ring are drawn whole
+            CGE_Frame_Ring::Slice indirect{};
+            if (meshlet_count > 1) {
+                indirect = frame_info.frame_ring.allocate(meshlet_count * sizeof(VkDrawIndexedIndirectCommand));
+            }
+            if (indirect.valid()) {
+                CGE_Frustum frustum = CGE_Frustum::from_matrix(projection_view * model_matrix);
+
+                glm::vec3 camera_position{};
+                if (this->_cluster_backface_culling) {
+                    glm::mat4 object_to_view = frame_info.camera.get_view_matrix() * model_matrix;
+                    camera_position = glm::vec3(glm::inverse(object_to_view)[3]);
+                }
+
+                uint32_t draw_count = cge_cull_meshlets(
+                    model->get_meshlets().data() + first_meshlet,
+                    meshlet_count,
+                    frustum,
+                    this->_cluster_backface_culling ? &camera_position : nullptr,
+                    static_cast<VkDrawIndexedIndirectCommand*>(indirect.data),
+                    model->get_first_index(),
+                    model->get_base_vertex());
+
+                model->_draw_indirect(
+                    frame_info.command_buffer,
+                    indirect.buffer,
+                    indirect.offset,
+                    draw_count);
+            } else {
+                model->_draw(frame_info.command_buffer, lod);
+            }
         }
     }
 
     //
-    // Create the pipeline
+    // Create the pipelines
     //
     void 
     SimpleRenderSystem::_create_pipeline(VkRenderPass render_pass) {
         assert(this->_pipeline_layout != nullptr && "Cannot create pipeline before pipeline layout");
 
+        for (uint32_t i = 0; i < CGE_VERTEX_FORMAT_COUNT; i++) {
+            auto format = static_cast<CGE_Vertex_Format>(i);
+
+            PipelineConfigInfo pipeline_config{};
+            CGE_Pipeline::_default_pipeline_config_info(pipeline_config);
+            pipeline_config._binding_descriptions = CGE_Model::get_binding_description(format);
+            pipeline_config._attribute_descriptions = CGE_Model::get_attribute_description(format);
+            pipeline_config._render_pass = render_pass;
+            pipeline_config._pipeline_layout = this->_pipeline_layout;
+            this->_pipelines[i] = std::make_unique<CGE_Pipeline>(
+                    this->_device,
+                    format == CGE_Vertex_Format::FULL
+                        ? "shaders/vert/simple.vert.spv"
+                        : "shaders/vert/packed.vert.spv",
+                    "shaders/frag/simple.frag.spv",
+                    pipeline_config
+                );
+        }
+    }
+
+    //
+    // Create the vertex pulling pipeline and its layout. It has no vertex
+    // input state; every format is decoded by shaders/vert/pulling.vert
+    //
+    void
+    SimpleRenderSystem::_create_pulling_pipeline(VkRenderPass render_pass) {
+        VkPushConstantRange push_constant_range{};
+        // simple.frag declares the push block too, so the range covers it
+        push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        push_constant_range.offset = 0;
+        push_constant_range.size = sizeof(PullingPushConstantData);
+
+        VkPipelineLayoutCreateInfo pipeline_layout_info {};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_info.setLayoutCount = 0;
+        pipeline_layout_info.pSetLayouts = nullptr;
+        pipeline_layout_info.pushConstantRangeCount = 1;
+        pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+        if (vkCreatePipelineLayout(
+                this->_device.device(),
+                &pipeline_layout_info,
+                nullptr,
+                &this->_pulling_pipeline_layout
+            ) != VK_SUCCESS) {
+            throw std::runtime_error("Error: failed to create vertex pulling pipeline layout");
+        }
+
         PipelineConfigInfo pipeline_config{};
         CGE_Pipeline::_default_pipeline_config_info(pipeline_config);
+        pipeline_config._binding_descriptions.clear();
+        pipeline_config._attribute_descriptions.clear();
         pipeline_config._render_pass = render_pass;
-        pipeline_config._pipeline_layout = this->_pipeline_layout;
-        this->_pipeline = std::make_unique<CGE_Pipeline>(
+        pipeline_config._pipeline_layout = this->_pulling_pipeline_layout;
+        this->_pulling_pipeline = std::make_unique<CGE_Pipeline>(
                 this->_device,
-                "shaders/vert/simple.vert.spv",
+                "shaders/vert/pulling.vert.spv",
                 "shaders/frag/simple.frag.spv",
                 pipeline_config
             );